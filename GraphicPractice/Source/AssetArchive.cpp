@@ -0,0 +1,260 @@
+#include "AssetArchive.h"
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+std::vector<std::unique_ptr<AssetArchive>> AssetArchive::mounted;
+
+static const char archiveMagic[4] = { 'G', 'P', 'K', '1' };
+
+struct ArchiveHeader
+{
+	char magic[4];
+	uint32_t entryCount;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+};
+
+static uint64_t AlignBlob(uint64_t offset)
+{
+	return (offset + AssetArchive::blobAlignment - 1) & ~(uint64_t)(AssetArchive::blobAlignment - 1);
+}
+
+// a temporary file of its own for every write, two packers can target the same archive
+static std::string TempPathFor(const std::string& path)
+{
+	static const unsigned int processTag = std::random_device()();
+	static std::atomic<unsigned int> counter(0);
+	return path + "." + std::to_string(processTag) + "." + std::to_string(counter++) + ".tmp";
+}
+
+std::string AssetArchive::NormalizeName(std::string_view name)
+{
+	std::string path(name);
+	std::replace(path.begin(), path.end(), '\\', '/');
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+std::string_view AssetArchive::NameOf(const Entry& entry) const
+{
+	return std::string_view(names + entry.nameOffset, entry.nameLength);
+}
+
+bool AssetArchive::Open(const std::string& path)
+{
+	entries = nullptr;
+	entryCount = 0;
+	decoded.clear();
+	if (!file.Open(path))
+		return false;
+	size_t size = file.GetSize();
+	ArchiveHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, file.GetData(), sizeof(header));
+	uint64_t indexEnd = sizeof(header) + (uint64_t)header.entryCount * sizeof(Entry);
+	if (memcmp(header.magic, archiveMagic, sizeof(archiveMagic)) != 0 || indexEnd > size ||
+		header.namesOffset < indexEnd || header.namesOffset > size || header.namesSize > size - header.namesOffset)
+	{
+		std::cout << "ERROR::ASSET_ARCHIVE::INVALID_HEADER " << path << std::endl;
+		return false;
+	}
+	// the header keeps the index 8 byte aligned inside the page aligned mapping
+	const Entry* index = (const Entry*)(file.GetData() + sizeof(header));
+	for (uint32_t i = 0; i < header.entryCount; i++)
+	{
+		const Entry& entry = index[i];
+		if (entry.offset > size || entry.storedSize > size - entry.offset ||
+			(uint64_t)entry.nameOffset + entry.nameLength > header.namesSize ||
+			(!(entry.flags & Compressed) && entry.storedSize != entry.size))
+		{
+			std::cout << "ERROR::ASSET_ARCHIVE::INVALID_ENTRY " << path << std::endl;
+			return false;
+		}
+	}
+	entries = index;
+	entryCount = header.entryCount;
+	names = file.GetData() + header.namesOffset;
+	return true;
+}
+
+bool AssetArchive::Contains(std::string_view name) const
+{
+	std::string normalized = NormalizeName(name);
+	const Entry* end = entries + entryCount;
+	const Entry* it = std::lower_bound(entries, end, std::string_view(normalized),
+		[this](const Entry& entry, std::string_view key) { return NameOf(entry) < key; });
+	return it != end && NameOf(*it) == normalized;
+}
+
+bool AssetArchive::Find(std::string_view name, std::string_view& data)
+{
+	std::string normalized = NormalizeName(name);
+	const Entry* end = entries + entryCount;
+	const Entry* it = std::lower_bound(entries, end, std::string_view(normalized),
+		[this](const Entry& entry, std::string_view key) { return NameOf(entry) < key; });
+	if (it == end || NameOf(*it) != normalized)
+		return false;
+	std::string_view stored(file.GetData() + it->offset, (size_t)it->storedSize);
+	if (!(it->flags & Compressed))
+	{
+		data = stored;
+		return true;
+	}
+
+	// loader threads may ask for the same entry at once
+	std::lock_guard<std::mutex> lock(decodedMutex);
+	uint32_t index = (uint32_t)(it - entries);
+	std::unique_ptr<char[]>& buffer = decoded[index];
+	if (!buffer)
+	{
+		std::unique_ptr<char[]> output(new char[it->size ? (size_t)it->size : 1]);
+		if (!BlockCompression::Decompress(stored, output.get(), (size_t)it->size))
+		{
+			std::cout << "ERROR::ASSET_ARCHIVE::CORRUPT_ENTRY " << normalized << std::endl;
+			decoded.erase(index);
+			return false;
+		}
+		buffer = std::move(output);
+	}
+	data = std::string_view(buffer.get(), (size_t)it->size);
+	return true;
+}
+
+bool AssetArchive::Write(const std::string& path, const std::vector<std::pair<std::string, std::string>>& files, bool compress)
+{
+	struct Packed
+	{
+		std::string name;
+		std::string contents;
+		std::vector<char> compressed;
+	};
+	std::vector<Packed> packed;
+	for (const auto& file : files)
+	{
+		std::ifstream input(file.second, std::ios::binary);
+		if (!input)
+		{
+			std::cout << "ERROR::ASSET_ARCHIVE::CANNOT_READ " << file.second << std::endl;
+			return false;
+		}
+		std::stringstream stream;
+		stream << input.rdbuf();
+		Packed entry;
+		entry.name = NormalizeName(file.first);
+		entry.contents = stream.str();
+		if (compress)
+		{
+			entry.compressed = BlockCompression::Compress(entry.contents);
+			// images are compressed already, storing them keeps reads zero-copy
+			if (entry.compressed.size() > entry.contents.size() - entry.contents.size() / 8)
+				entry.compressed.clear();
+		}
+		packed.push_back(std::move(entry));
+	}
+	// lookups binary search the index
+	std::sort(packed.begin(), packed.end(), [](const Packed& a, const Packed& b) { return a.name < b.name; });
+
+	ArchiveHeader header = {};
+	memcpy(header.magic, archiveMagic, sizeof(archiveMagic));
+	header.entryCount = (uint32_t)packed.size();
+	header.namesOffset = sizeof(header) + packed.size() * sizeof(Entry);
+	std::string nameTable;
+	std::vector<Entry> index(packed.size());
+	for (size_t i = 0; i < packed.size(); i++)
+	{
+		index[i] = Entry();
+		index[i].nameOffset = (uint32_t)nameTable.size();
+		index[i].nameLength = (uint32_t)packed[i].name.size();
+		nameTable += packed[i].name;
+	}
+	header.namesSize = nameTable.size();
+	uint64_t offset = AlignBlob(header.namesOffset + header.namesSize);
+	for (size_t i = 0; i < packed.size(); i++)
+	{
+		bool isCompressed = !packed[i].compressed.empty();
+		index[i].offset = offset;
+		index[i].size = packed[i].contents.size();
+		index[i].storedSize = isCompressed ? packed[i].compressed.size() : packed[i].contents.size();
+		index[i].flags = isCompressed ? (uint32_t)Compressed : 0u;
+		offset = AlignBlob(offset + index[i].storedSize);
+	}
+
+	// write to a temporary file first so a running game never maps half an archive
+	std::string tempPath = TempPathFor(path);
+	bool complete;
+	{
+		std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+		if (!output)
+		{
+			std::cout << "ERROR::ASSET_ARCHIVE::CANNOT_WRITE " << tempPath << std::endl;
+			return false;
+		}
+		static const char padding[blobAlignment] = {};
+		output.write((const char*)&header, sizeof(header));
+		output.write((const char*)index.data(), index.size() * sizeof(Entry));
+		output.write(nameTable.data(), nameTable.size());
+		uint64_t written = header.namesOffset + header.namesSize;
+		for (size_t i = 0; i < packed.size(); i++)
+		{
+			output.write(padding, (std::streamsize)(index[i].offset - written));
+			if (index[i].flags & Compressed)
+				output.write(packed[i].compressed.data(), packed[i].compressed.size());
+			else
+				output.write(packed[i].contents.data(), packed[i].contents.size());
+			written = index[i].offset + index[i].storedSize;
+		}
+		complete = (bool)output;
+	}
+	// a short write (disk full) leaves nothing behind either
+	std::error_code error;
+	if (complete)
+		std::filesystem::rename(tempPath, path, error);
+	if (!complete || error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool AssetArchive::Mount(const std::string& path)
+{
+	std::unique_ptr<AssetArchive> archive(new AssetArchive());
+	if (!archive->Open(path))
+		return false;
+	mounted.push_back(std::move(archive));
+	return true;
+}
+
+void AssetArchive::UnmountAll()
+{
+	mounted.clear();
+}
+
+bool AssetArchive::FindMounted(std::string_view name, std::string_view& data)
+{
+	for (const std::unique_ptr<AssetArchive>& archive : mounted)
+	{
+		if (archive->Find(name, data))
+			return true;
+	}
+	return false;
+}
+
+bool AssetArchive::ContainsMounted(std::string_view name)
+{
+	for (const std::unique_ptr<AssetArchive>& archive : mounted)
+	{
+		if (archive->Contains(name))
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,73 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Single memory mapped file holding many assets: header, index sorted by name,
+// name table, then every blob aligned to blobAlignment. Stored blobs are handed
+// out as views into the mapping; compressed ones (BlockCompression) are decoded
+// once and kept until the archive closes.
+class AssetArchive
+{
+public:
+	static const size_t blobAlignment = 64;
+
+	struct Entry
+	{
+		uint64_t offset;
+		uint64_t storedSize;
+		uint64_t size;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint32_t flags;
+		uint32_t reserved;
+	};
+	enum EntryFlags : uint32_t
+	{
+		Compressed = 1
+	};
+private:
+	MappedFile file;
+	const Entry* entries = nullptr;
+	uint32_t entryCount = 0;
+	const char* names = nullptr;
+	std::mutex decodedMutex;
+	std::unordered_map<uint32_t, std::unique_ptr<char[]>> decoded;
+
+	static std::vector<std::unique_ptr<AssetArchive>> mounted;
+
+	std::string_view NameOf(const Entry& entry) const;
+public:
+	AssetArchive() = default;
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+
+	// maps the archive and checks the index, false if missing or malformed
+	bool Open(const std::string& path);
+	// contents of a file, views stay valid while the archive is open
+	bool Find(std::string_view name, std::string_view& data);
+	bool Contains(std::string_view name) const;
+	size_t GetEntryCount() const { return entryCount; }
+
+	// separators and "." / ".." resolved the same way for packing and lookup
+	static std::string NormalizeName(std::string_view name);
+	// packs (archive name, file on disk) pairs, compressing where it saves at least an eighth
+	static bool Write(const std::string& path, const std::vector<std::pair<std::string, std::string>>& files, bool compress);
+
+	// mounted archives are searched in mount order by AssetFile; mount before loader threads start
+	static bool Mount(const std::string& path);
+	static void UnmountAll();
+	static bool FindMounted(std::string_view name, std::string_view& data);
+	static bool ContainsMounted(std::string_view name);
+};
+
+#endif
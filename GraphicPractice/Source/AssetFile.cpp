@@ -0,0 +1,57 @@
+#include "AssetFile.h"
+#include "AssetArchive.h"
+
+#include <filesystem>
+#include <fstream>
+
+AssetFile::AssetFile(const std::string& path)
+{
+	Open(path);
+}
+
+bool AssetFile::Open(const std::string& path)
+{
+	file.Close();
+	buffer.clear();
+	view = std::string_view();
+	open = AssetArchive::FindMounted(path, view);
+	if (!open && file.Open(path))
+	{
+		view = file.GetView();
+		open = true;
+	}
+	return open;
+}
+
+bool AssetFile::OpenLoose(const std::string& path)
+{
+	file.Close();
+	buffer.clear();
+	view = std::string_view();
+	// copied, not mapped: touching a mapped page past the end of a file that
+	// was truncated meanwhile raises SIGBUS
+	std::error_code error;
+	std::ifstream stream;
+	if (std::filesystem::is_regular_file(path, error))
+		stream.open(path, std::ios::binary | std::ios::ate);
+	std::streamoff size = stream.is_open() ? (std::streamoff)stream.tellg() : -1;
+	open = size >= 0;
+	if (open)
+	{
+		buffer.resize((size_t)size);
+		stream.seekg(0);
+		stream.read(buffer.data(), (std::streamsize)buffer.size());
+		// shrunk while reading, keep what arrived and let the next event reload it
+		buffer.resize((size_t)stream.gcount());
+		view = std::string_view(buffer.data(), buffer.size());
+	}
+	else
+		open = AssetArchive::FindMounted(path, view);
+	return open;
+}
+
+bool AssetFile::Exists(const std::string& path)
+{
+	std::error_code error;
+	return AssetArchive::ContainsMounted(path) || std::filesystem::exists(path, error);
+}
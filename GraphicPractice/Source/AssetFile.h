@@ -0,0 +1,36 @@
+#ifndef ASSET_FILE_H
+#define ASSET_FILE_H
+
+#include "MappedFile.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only contents of an asset, taken from a mounted AssetArchive when it
+// holds the path and mapped from the loose file otherwise
+class AssetFile
+{
+private:
+	MappedFile file;
+	// contents read by OpenLoose, a vector keeps view valid when moved
+	std::vector<char> buffer;
+	std::string_view view;
+	bool open = false;
+public:
+	AssetFile() = default;
+	explicit AssetFile(const std::string& path);
+
+	bool Open(const std::string& path);
+	// loose file before the archive, for files that are being edited (shader reloads);
+	// the file is read into memory, an editor may truncate it under a mapping
+	bool OpenLoose(const std::string& path);
+	bool IsOpen() const { return open; }
+	const char* GetData() const { return view.data(); }
+	size_t GetSize() const { return view.size(); }
+	std::string_view GetView() const { return view; }
+	// in a mounted archive or on disk
+	static bool Exists(const std::string& path);
+};
+
+#endif
@@ -0,0 +1,344 @@
+#include "AsyncFileReader.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+struct AsyncFileReader::Request
+{
+	FileRead read;
+	Callback onRead;
+	int fd = -1;
+	// bytes already read
+	size_t done = 0;
+};
+
+// finishes a read on the calling pool thread, from where the kernel left off
+void AsyncFileReader::ReadOnPool(Request* request)
+{
+	FileRead& read = request->read;
+#ifdef _WIN32
+	std::ifstream file(read.path, std::ios::binary | std::ios::ate);
+	read.success = (bool)file;
+	if (file)
+	{
+		read.data.resize((size_t)file.tellg());
+		file.seekg(request->done);
+		file.read(read.data.data() + request->done, read.data.size() - request->done);
+		read.success = (bool)file;
+	}
+#else
+	if (request->fd < 0)
+		request->fd = open(read.path.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat info;
+	read.success = request->fd >= 0 && fstat(request->fd, &info) == 0;
+	if (read.success)
+	{
+		read.data.resize((size_t)info.st_size);
+		while (request->done < read.data.size())
+		{
+			ssize_t count = pread(request->fd, read.data.data() + request->done, read.data.size() - request->done, request->done);
+			if (count < 0 && errno == EINTR)
+				continue;
+			if (count <= 0)
+			{
+				read.success = false;
+				break;
+			}
+			request->done += count;
+		}
+	}
+	if (request->fd >= 0)
+		close(request->fd);
+#endif
+	if (!read.success)
+		read.data.clear();
+	request->onRead(read);
+	delete request;
+}
+
+#ifdef __linux__
+
+struct AsyncFileReader::Ring
+{
+	int fd = -1;
+	unsigned int sqEntries = 0;
+	unsigned int cqEntries = 0;
+	void* sqRing = nullptr;
+	size_t sqRingSize = 0;
+	void* cqRing = nullptr;
+	size_t cqRingSize = 0;
+	io_uring_sqe* sqes = nullptr;
+	unsigned* sqTail = nullptr;
+	unsigned* sqMask = nullptr;
+	unsigned* sqArray = nullptr;
+	unsigned* cqHead = nullptr;
+	unsigned* cqTail = nullptr;
+	unsigned* cqMask = nullptr;
+	io_uring_cqe* cqes = nullptr;
+
+	std::thread reaper;
+	std::mutex mutex;
+	std::condition_variable space;
+	// submitted and not yet reaped, kept below cqEntries so completions never overflow
+	unsigned int inFlight = 0;
+	bool stopping = false;
+
+	~Ring()
+	{
+		if (sqes)
+			munmap(sqes, sqEntries * sizeof(io_uring_sqe));
+		if (cqRing && cqRing != sqRing)
+			munmap(cqRing, cqRingSize);
+		if (sqRing)
+			munmap(sqRing, sqRingSize);
+		if (fd >= 0)
+			close(fd);
+	}
+
+	bool Setup(unsigned int depth)
+	{
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		// no liburing, the three syscalls and the shared rings are all it takes
+		fd = (int)syscall(__NR_io_uring_setup, depth, &params);
+		if (fd < 0)
+			return false;
+		sqEntries = params.sq_entries;
+		cqEntries = params.cq_entries;
+		sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (singleMap)
+			sqRingSize = cqRingSize = sqRingSize > cqRingSize ? sqRingSize : cqRingSize;
+		sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		if (sqRing == MAP_FAILED)
+		{
+			sqRing = nullptr;
+			return false;
+		}
+		cqRing = singleMap ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (cqRing == MAP_FAILED)
+		{
+			cqRing = nullptr;
+			return false;
+		}
+		void* sqeMap = mmap(nullptr, sqEntries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+		if (sqeMap == MAP_FAILED)
+			return false;
+		sqes = (io_uring_sqe*)sqeMap;
+
+		char* sq = (char*)sqRing;
+		sqTail = (unsigned*)(sq + params.sq_off.tail);
+		sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+		sqArray = (unsigned*)(sq + params.sq_off.array);
+		char* cq = (char*)cqRing;
+		cqHead = (unsigned*)(cq + params.cq_off.head);
+		cqTail = (unsigned*)(cq + params.cq_off.tail);
+		cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+		cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+		return true;
+	}
+
+	// fills the next submission entry, mutex held
+	void Queue(unsigned char opcode, int file, void* buffer, unsigned int length, uint64_t offset, Request* request)
+	{
+		unsigned tail = *sqTail;
+		unsigned index = tail & *sqMask;
+		io_uring_sqe& sqe = sqes[index];
+		memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = opcode;
+		sqe.fd = file;
+		sqe.addr = (uint64_t)(uintptr_t)buffer;
+		sqe.len = length;
+		sqe.off = offset;
+		sqe.user_data = (uint64_t)(uintptr_t)request;
+		sqArray[index] = index;
+		// the kernel must see the entry before the new tail
+		__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+		inFlight++;
+	}
+};
+
+AsyncFileReader::AsyncFileReader(ThreadPool& pool, unsigned int queueDepth)
+	: pool(pool)
+{
+	ring.reset(new Ring());
+	// kernels before 5.1 or sandboxes that block the syscalls use the pool
+	if (!ring->Setup(queueDepth))
+	{
+		ring.reset();
+		return;
+	}
+	ring->reaper = std::thread(&AsyncFileReader::Reap, this);
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+	if (!ring)
+		return;
+	{
+		// a no-op wakes the reaper, which leaves once everything before it completed
+		std::unique_lock<std::mutex> lock(ring->mutex);
+		ring->space.wait(lock, [this]() { return ring->inFlight < ring->cqEntries; });
+		ring->stopping = true;
+		unsigned queued = 1;
+		ring->Queue(IORING_OP_NOP, -1, nullptr, 0, 0, nullptr);
+		Enter(queued);
+	}
+	ring->reaper.join();
+}
+
+void AsyncFileReader::Enter(unsigned& queued)
+{
+	while (queued > 0)
+	{
+		int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, queued, 0, 0, nullptr, 0);
+		if (submitted < 0 && errno == EINTR)
+			continue;
+		if (submitted <= 0)
+			break;
+		queued -= submitted;
+	}
+}
+
+void AsyncFileReader::Read(const std::vector<std::string>& paths, Callback onRead)
+{
+	if (!ring)
+	{
+		for (const std::string& path : paths)
+		{
+			Request* request = new Request();
+			request->read.path = path;
+			request->onRead = onRead;
+			pool.Submit([request]() { ReadOnPool(request); });
+		}
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(ring->mutex);
+	unsigned queued = 0;
+	for (const std::string& path : paths)
+	{
+		Request* request = new Request();
+		request->read.path = path;
+		request->onRead = onRead;
+		request->fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat info;
+		// missing and empty files need no kernel read, the pool reports them
+		if (request->fd < 0 || fstat(request->fd, &info) != 0 || info.st_size == 0)
+		{
+			pool.Submit([request]() { ReadOnPool(request); });
+			continue;
+		}
+		request->read.data.resize((size_t)info.st_size);
+
+		if (ring->inFlight >= ring->cqEntries || queued == ring->sqEntries)
+		{
+			// whatever is queued must reach the kernel before waiting on its completions
+			Enter(queued);
+			ring->space.wait(lock, [this]() { return ring->inFlight < ring->cqEntries; });
+		}
+		// one read covers up to 2 GiB, anything left is finished on the pool
+		unsigned int length = request->read.data.size() > 0x7ffff000 ? 0x7ffff000 : (unsigned int)request->read.data.size();
+		ring->Queue(IORING_OP_READ, request->fd, request->read.data.data(), length, 0, request);
+		queued++;
+	}
+	// the whole batch goes to the kernel in one call
+	Enter(queued);
+}
+
+void AsyncFileReader::Reap()
+{
+	while (true)
+	{
+		int result = (int)syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+		if (result < 0 && errno != EINTR)
+			break;
+
+		unsigned head = *ring->cqHead;
+		unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+		unsigned reaped = 0;
+		for (; head != tail; head++, reaped++)
+		{
+			const io_uring_cqe& cqe = ring->cqes[head & *ring->cqMask];
+			Request* request = (Request*)(uintptr_t)cqe.user_data;
+			if (!request)
+				continue;
+			if (cqe.res > 0)
+				request->done += cqe.res;
+			if (cqe.res >= 0 && request->done == request->read.data.size())
+			{
+				close(request->fd);
+				request->read.success = true;
+				pool.Submit([request]()
+				{
+					request->onRead(request->read);
+					delete request;
+				});
+			}
+			else
+			{
+				// short reads and kernels without IORING_OP_READ continue with pread
+				pool.Submit([request]() { ReadOnPool(request); });
+			}
+		}
+		__atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+
+		std::lock_guard<std::mutex> lock(ring->mutex);
+		ring->inFlight -= reaped;
+		ring->space.notify_all();
+		if (ring->stopping && ring->inFlight == 0)
+			break;
+	}
+}
+
+#else
+
+struct AsyncFileReader::Ring
+{
+};
+
+AsyncFileReader::AsyncFileReader(ThreadPool& pool, unsigned int queueDepth)
+	: pool(pool)
+{
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+}
+
+void AsyncFileReader::Enter(unsigned& queued)
+{
+}
+
+void AsyncFileReader::Reap()
+{
+}
+
+void AsyncFileReader::Read(const std::vector<std::string>& paths, Callback onRead)
+{
+	for (const std::string& path : paths)
+	{
+		Request* request = new Request();
+		request->read.path = path;
+		request->onRead = onRead;
+		pool.Submit([request]() { ReadOnPool(request); });
+	}
+}
+
+#endif
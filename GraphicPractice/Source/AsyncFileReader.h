@@ -0,0 +1,51 @@
+#ifndef ASYNC_FILE_READER_H
+#define ASYNC_FILE_READER_H
+
+#include "ThreadPool.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct FileRead
+{
+	std::string path;
+	std::vector<char> data;
+	bool success = false;
+};
+
+// Reads whole files without blocking the caller. On Linux a batch of reads is
+// queued to io_uring in one submission so cold reads overlap in the kernel;
+// elsewhere (or when io_uring is unavailable) every file is read with pread
+// on the thread pool. Completed files are handed to the pool either way.
+class AsyncFileReader
+{
+public:
+	// runs on a pool thread, may take the data
+	using Callback = std::function<void(FileRead&)>;
+private:
+	struct Request;
+	struct Ring;
+	ThreadPool& pool;
+	std::unique_ptr<Ring> ring;
+
+	static void ReadOnPool(Request* request);
+	void Reap();
+	// queued reads are passed to the kernel, ring mutex held
+	void Enter(unsigned& queued);
+public:
+	// queueDepth caps the reads the kernel works on at once
+	explicit AsyncFileReader(ThreadPool& pool, unsigned int queueDepth = 64);
+	// waits for reads still in the kernel, callbacks may still be queued on the pool
+	~AsyncFileReader();
+	AsyncFileReader(const AsyncFileReader&) = delete;
+	AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+	// reads every file, onRead runs once per path as each completes
+	void Read(const std::vector<std::string>& paths, Callback onRead);
+	// false when reads fall back to the thread pool
+	bool UsesIoUring() const { return ring != nullptr; }
+};
+
+#endif
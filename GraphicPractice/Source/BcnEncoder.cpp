@@ -0,0 +1,613 @@
+#include "BcnEncoder.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// mean and dominant direction of 16 points with dims components
+static void PrincipalAxis(const float points[16][4], int dims, float mean[4], float axis[4])
+{
+	for (int c = 0; c < 4; c++)
+		mean[c] = 0.0f;
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < dims; c++)
+			mean[c] += points[i][c] / 16.0f;
+	float covariance[4][4] = {};
+	for (int i = 0; i < 16; i++)
+		for (int a = 0; a < dims; a++)
+			for (int b = 0; b < dims; b++)
+				covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+	// power iteration converges in a few steps for a 3x3/4x4 covariance
+	float v[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4] = {};
+		float length = 0.0f;
+		for (int a = 0; a < dims; a++)
+		{
+			for (int b = 0; b < dims; b++)
+				next[a] += covariance[a][b] * v[b];
+			length += next[a] * next[a];
+		}
+		length = std::sqrt(length);
+		// flat block, any direction works
+		if (length < 1e-6f)
+			break;
+		for (int a = 0; a < dims; a++)
+			v[a] = next[a] / length;
+	}
+	float length = 0.0f;
+	for (int a = 0; a < dims; a++)
+		length += v[a] * v[a];
+	length = std::sqrt(length);
+	for (int a = 0; a < 4; a++)
+		axis[a] = a < dims ? v[a] / length : 0.0f;
+}
+
+// endpoints at the extremes of the projection onto the axis
+static void AxisEndpoints(const float points[16][4], int dims, float high[4], float low[4])
+{
+	float mean[4], axis[4];
+	PrincipalAxis(points, dims, mean, axis);
+	float minT = 0.0f, maxT = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		float t = 0.0f;
+		for (int c = 0; c < dims; c++)
+			t += (points[i][c] - mean[c]) * axis[c];
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	for (int c = 0; c < 4; c++)
+	{
+		high[c] = c < dims ? mean[c] + axis[c] * maxT : 0.0f;
+		low[c] = c < dims ? mean[c] + axis[c] * minT : 0.0f;
+	}
+}
+
+// least squares endpoints for fixed per pixel weights of the high endpoint
+static void RefineEndpoints(const float points[16][4], int dims, const float weights[16], float high[4], float low[4])
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ap[4] = {}, bp[4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float a = weights[i], b = 1.0f - weights[i];
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < dims; c++)
+		{
+			ap[c] += a * points[i][c];
+			bp[c] += b * points[i][c];
+		}
+	}
+	float determinant = aa * bb - ab * ab;
+	// every pixel on the same palette entry, nothing to solve
+	if (std::fabs(determinant) < 1e-6f)
+		return;
+	for (int c = 0; c < dims; c++)
+	{
+		high[c] = std::min(std::max((ap[c] * bb - bp[c] * ab) / determinant, 0.0f), 255.0f);
+		low[c] = std::min(std::max((bp[c] * aa - ap[c] * ab) / determinant, 0.0f), 255.0f);
+	}
+}
+
+static int Clamp(int value, int low, int high)
+{
+	return value < low ? low : value > high ? high : value;
+}
+
+static uint16_t To565(const float color[4])
+{
+	int r = Clamp((int)std::lround(color[0] * 31.0f / 255.0f), 0, 31);
+	int g = Clamp((int)std::lround(color[1] * 63.0f / 255.0f), 0, 63);
+	int b = Clamp((int)std::lround(color[2] * 31.0f / 255.0f), 0, 31);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void From565(uint16_t value, int color[4])
+{
+	int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+	color[3] = 255;
+}
+
+static void Bc1Palette(uint16_t c0, uint16_t c1, bool fourColor, int palette[4][4])
+{
+	From565(c0, palette[0]);
+	From565(c1, palette[1]);
+	for (int c = 0; c < 4; c++)
+	{
+		if (fourColor)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+}
+
+// writes the color half of a BC1/BC3 block, returns the squared error
+static int WriteBc1Colors(const float points[16][4], uint16_t c0, uint16_t c1, unsigned char* block, unsigned char indices[16])
+{
+	// four color mode needs c0 > c1; equal endpoints leave every pixel on index 0
+	if (c0 < c1)
+		std::swap(c0, c1);
+	int palette[4][4];
+	Bc1Palette(c0, c1, true, palette);
+	int error = 0;
+	uint32_t bits = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int best = 0, bestError = INT32_MAX;
+		for (int k = 0; k < (c0 == c1 ? 1 : 4); k++)
+		{
+			int e = 0;
+			for (int c = 0; c < 3; c++)
+			{
+				int d = palette[k][c] - (int)points[i][c];
+				e += d * d;
+			}
+			if (e < bestError)
+			{
+				bestError = e;
+				best = k;
+			}
+		}
+		indices[i] = (unsigned char)best;
+		bits |= (uint32_t)best << (i * 2);
+		error += bestError;
+	}
+	block[0] = (unsigned char)(c0 & 0xff);
+	block[1] = (unsigned char)(c0 >> 8);
+	block[2] = (unsigned char)(c1 & 0xff);
+	block[3] = (unsigned char)(c1 >> 8);
+	memcpy(block + 4, &bits, 4);
+	return error;
+}
+
+static void EncodeBc1Colors(const float points[16][4], unsigned char* block)
+{
+	float high[4], low[4];
+	AxisEndpoints(points, 3, high, low);
+	// pull the endpoints in a little, the extremes are rarely hit exactly
+	for (int c = 0; c < 3; c++)
+	{
+		float inset = (high[c] - low[c]) / 16.0f;
+		high[c] -= inset;
+		low[c] += inset;
+	}
+	unsigned char indices[16];
+	int error = WriteBc1Colors(points, To565(high), To565(low), block, indices);
+
+	// one least squares pass over the chosen indices, kept only when it helps
+	static const float highWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	float weights[16];
+	for (int i = 0; i < 16; i++)
+		weights[i] = highWeights[indices[i]];
+	RefineEndpoints(points, 3, weights, high, low);
+	unsigned char refined[8];
+	if (WriteBc1Colors(points, To565(high), To565(low), refined, indices) < error)
+		memcpy(block, refined, 8);
+}
+
+static void Bc4Palette(int a0, int a1, int palette[8])
+{
+	palette[0] = a0;
+	palette[1] = a1;
+	for (int k = 1; k < 7; k++)
+		palette[k + 1] = a0 > a1 ? ((7 - k) * a0 + k * a1 + 3) / 7 : 0;
+	// six value mode, only reached when both endpoints are equal here
+	if (a0 <= a1)
+	{
+		for (int k = 1; k < 5; k++)
+			palette[k + 1] = ((5 - k) * a0 + k * a1 + 2) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static void EncodeBc4Channel(const unsigned char* rgba, int channel, unsigned char* block)
+{
+	int low = 255, high = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		low = std::min(low, (int)rgba[i * 4 + channel]);
+		high = std::max(high, (int)rgba[i * 4 + channel]);
+	}
+	int palette[8];
+	Bc4Palette(high, low, palette);
+	uint64_t bits = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int value = rgba[i * 4 + channel];
+		int best = 0, bestError = INT32_MAX;
+		for (int k = 0; k < (high == low ? 1 : 8); k++)
+		{
+			int e = std::abs(palette[k] - value);
+			if (e < bestError)
+			{
+				bestError = e;
+				best = k;
+			}
+		}
+		bits |= (uint64_t)best << (i * 3);
+	}
+	block[0] = (unsigned char)high;
+	block[1] = (unsigned char)low;
+	for (int b = 0; b < 6; b++)
+		block[2 + b] = (unsigned char)(bits >> (b * 8));
+}
+
+static void DecodeBc4Channel(const unsigned char* block, unsigned char* rgba, int channel)
+{
+	int palette[8];
+	Bc4Palette(block[0], block[1], palette);
+	uint64_t bits = 0;
+	for (int b = 0; b < 6; b++)
+		bits |= (uint64_t)block[2 + b] << (b * 8);
+	for (int i = 0; i < 16; i++)
+		rgba[i * 4 + channel] = (unsigned char)palette[(bits >> (i * 3)) & 7];
+}
+
+static void DecodeBc1Colors(const unsigned char* block, unsigned char* rgba, bool alwaysFourColor)
+{
+	uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+	uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+	int palette[4][4];
+	Bc1Palette(c0, c1, alwaysFourColor || c0 > c1, palette);
+	uint32_t bits;
+	memcpy(&bits, block + 4, 4);
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 3; c++)
+			rgba[i * 4 + c] = (unsigned char)palette[(bits >> (i * 2)) & 3][c];
+}
+
+// 128 bit little endian bit stream of a BC7 block
+struct BitWriter
+{
+	unsigned char* data;
+	int position = 0;
+	void Write(uint32_t value, int count)
+	{
+		for (int i = 0; i < count; i++, position++)
+			if (value & (1u << i))
+				data[position >> 3] |= (unsigned char)(1 << (position & 7));
+	}
+};
+
+struct BitReader
+{
+	const unsigned char* data;
+	int position = 0;
+	uint32_t Read(int count)
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < count; i++, position++)
+			value |= (uint32_t)((data[position >> 3] >> (position & 7)) & 1) << i;
+		return value;
+	}
+};
+
+// 7 bit endpoint plus the p-bit that gives the closest 8 bit value
+static void QuantizeBc7Endpoint(const float endpoint[4], int quantized[4], int& pBit)
+{
+	float bestError = 1e30f;
+	for (int p = 0; p < 2; p++)
+	{
+		int q[4];
+		float error = 0.0f;
+		for (int c = 0; c < 4; c++)
+		{
+			q[c] = Clamp((int)std::lround((endpoint[c] - p) / 2.0f), 0, 127);
+			float d = (float)(q[c] * 2 + p) - endpoint[c];
+			error += d * d;
+		}
+		if (error < bestError)
+		{
+			bestError = error;
+			pBit = p;
+			memcpy(quantized, q, sizeof(q));
+		}
+	}
+}
+
+static int Bc7Indices(const float points[16][4], const int e0[4], const int e1[4], unsigned char indices[16])
+{
+	int palette[16][4];
+	for (int k = 0; k < 16; k++)
+		for (int c = 0; c < 4; c++)
+			palette[k][c] = ((64 - bc7Weights[k]) * e0[c] + bc7Weights[k] * e1[c] + 32) >> 6;
+	int error = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int best = 0, bestError = INT32_MAX;
+		for (int k = 0; k < 16; k++)
+		{
+			int e = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				int d = palette[k][c] - (int)points[i][c];
+				e += d * d;
+			}
+			if (e < bestError)
+			{
+				bestError = e;
+				best = k;
+			}
+		}
+		indices[i] = (unsigned char)best;
+		error += bestError;
+	}
+	return error;
+}
+
+// mode 6: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4 bit indices
+static int TryBc7Mode6(const float points[16][4], const float low[4], const float high[4], unsigned char* block)
+{
+	int q0[4], q1[4], p0, p1;
+	QuantizeBc7Endpoint(low, q0, p0);
+	QuantizeBc7Endpoint(high, q1, p1);
+	int e0[4], e1[4];
+	for (int c = 0; c < 4; c++)
+	{
+		e0[c] = q0[c] * 2 + p0;
+		e1[c] = q1[c] * 2 + p1;
+	}
+	unsigned char indices[16];
+	int error = Bc7Indices(points, e0, e1, indices);
+	// the anchor index is stored with its top bit implied zero
+	if (indices[0] & 8)
+	{
+		std::swap(q0, q1);
+		std::swap(p0, p1);
+		for (int i = 0; i < 16; i++)
+			indices[i] = (unsigned char)(15 - indices[i]);
+	}
+	memset(block, 0, 16);
+	BitWriter writer{ block };
+	writer.Write(1u << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		writer.Write(q0[c], 7);
+		writer.Write(q1[c], 7);
+	}
+	writer.Write(p0, 1);
+	writer.Write(p1, 1);
+	for (int i = 0; i < 16; i++)
+		writer.Write(indices[i], i == 0 ? 3 : 4);
+	return error;
+}
+
+static void EncodeBc7(const float points[16][4], unsigned char* block)
+{
+	float high[4], low[4];
+	AxisEndpoints(points, 4, high, low);
+	int error = TryBc7Mode6(points, low, high, block);
+
+	// least squares pass from the weights the first try picked
+	BitReader reader{ block };
+	reader.Read(7 + 56 + 2);
+	float weights[16];
+	for (int i = 0; i < 16; i++)
+		weights[i] = 1.0f - bc7Weights[reader.Read(i == 0 ? 3 : 4)] / 64.0f;
+	// weights belong to the first stored endpoint, whichever of the two it ended up being
+	float first[4], second[4];
+	memcpy(first, low, sizeof(first));
+	memcpy(second, high, sizeof(second));
+	RefineEndpoints(points, 4, weights, first, second);
+	unsigned char refined[16];
+	if (TryBc7Mode6(points, first, second, refined) < error)
+		memcpy(block, refined, 16);
+}
+
+static bool DecodeBc7(const unsigned char* block, unsigned char* rgba)
+{
+	if ((block[0] & 0x7f) != 0x40)
+		return false;
+	BitReader reader{ block };
+	reader.Read(7);
+	int e[2][4];
+	for (int c = 0; c < 4; c++)
+	{
+		e[0][c] = reader.Read(7) << 1;
+		e[1][c] = reader.Read(7) << 1;
+	}
+	int p0 = reader.Read(1), p1 = reader.Read(1);
+	for (int c = 0; c < 4; c++)
+	{
+		e[0][c] |= p0;
+		e[1][c] |= p1;
+	}
+	for (int i = 0; i < 16; i++)
+	{
+		int w = bc7Weights[reader.Read(i == 0 ? 3 : 4)];
+		for (int c = 0; c < 4; c++)
+			rgba[i * 4 + c] = (unsigned char)(((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6);
+	}
+	return true;
+}
+
+size_t BcnEncoder::BlockSize(BcFormat format)
+{
+	return format == BcFormat::BC1 || format == BcFormat::BC4 ? 8 : 16;
+}
+
+GLenum BcnEncoder::GlFormat(BcFormat format, bool srgb)
+{
+	switch (format)
+	{
+	case BcFormat::BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case BcFormat::BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case BcFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+	case BcFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+	default: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+}
+
+void BcnEncoder::EncodeBlock(BcFormat format, const unsigned char* rgba, unsigned char* block)
+{
+	float points[16][4];
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+			points[i][c] = rgba[i * 4 + c];
+	switch (format)
+	{
+	case BcFormat::BC1:
+		EncodeBc1Colors(points, block);
+		break;
+	case BcFormat::BC3:
+		EncodeBc4Channel(rgba, 3, block);
+		EncodeBc1Colors(points, block + 8);
+		break;
+	case BcFormat::BC4:
+		EncodeBc4Channel(rgba, 0, block);
+		break;
+	case BcFormat::BC5:
+		EncodeBc4Channel(rgba, 0, block);
+		EncodeBc4Channel(rgba, 1, block + 8);
+		break;
+	case BcFormat::BC7:
+		EncodeBc7(points, block);
+		break;
+	}
+}
+
+bool BcnEncoder::DecodeBlock(BcFormat format, const unsigned char* block, unsigned char* rgba)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = 0;
+		rgba[i * 4 + 3] = 255;
+	}
+	switch (format)
+	{
+	case BcFormat::BC1:
+		DecodeBc1Colors(block, rgba, false);
+		return true;
+	case BcFormat::BC3:
+		DecodeBc4Channel(block, rgba, 3);
+		DecodeBc1Colors(block + 8, rgba, true);
+		return true;
+	case BcFormat::BC4:
+		DecodeBc4Channel(block, rgba, 0);
+		return true;
+	case BcFormat::BC5:
+		DecodeBc4Channel(block, rgba, 0);
+		DecodeBc4Channel(block + 8, rgba, 1);
+		return true;
+	default:
+		return DecodeBc7(block, rgba);
+	}
+}
+
+static void EncodeBlockRows(BcFormat format, const unsigned char* rgba, int width, int height, int firstRow, int lastRow, unsigned char* out)
+{
+	int blocksX = (width + 3) / 4;
+	size_t blockSize = BcnEncoder::BlockSize(format);
+	unsigned char pixels[64];
+	for (int by = firstRow; by < lastRow; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			for (int y = 0; y < 4; y++)
+			{
+				int sy = std::min(by * 4 + y, height - 1);
+				for (int x = 0; x < 4; x++)
+				{
+					int sx = std::min(bx * 4 + x, width - 1);
+					memcpy(pixels + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+				}
+			}
+			BcnEncoder::EncodeBlock(format, pixels, out + ((size_t)by * blocksX + bx) * blockSize);
+		}
+	}
+}
+
+std::vector<unsigned char> BcnEncoder::EncodeImage(BcFormat format, const unsigned char* rgba, int width, int height, ThreadPool* pool)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	std::vector<unsigned char> blocks((size_t)blocksX * blocksY * BlockSize(format));
+	if (!pool || blocksY < 2)
+	{
+		EncodeBlockRows(format, rgba, width, height, 0, blocksY, blocks.data());
+		return blocks;
+	}
+	// a few chunks per thread so uneven blocks still balance
+	int chunks = std::min(blocksY, (int)pool->GetThreadCount() * 4);
+	std::mutex mutex;
+	std::condition_variable done;
+	int remaining = chunks;
+	for (int chunk = 0; chunk < chunks; chunk++)
+	{
+		int first = blocksY * chunk / chunks, last = blocksY * (chunk + 1) / chunks;
+		pool->Submit([&, first, last]()
+		{
+			EncodeBlockRows(format, rgba, width, height, first, last, blocks.data());
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--remaining == 0)
+				done.notify_one();
+		});
+	}
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [&]() { return remaining == 0; });
+	return blocks;
+}
+
+bool BcnEncoder::DecodeImage(BcFormat format, const unsigned char* blocks, int width, int height, std::vector<unsigned char>& rgba)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	rgba.assign((size_t)width * height * 4, 0);
+	unsigned char pixels[64];
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			if (!DecodeBlock(format, blocks + ((size_t)by * blocksX + bx) * BlockSize(format), pixels))
+				return false;
+			for (int y = 0; y < 4 && by * 4 + y < height; y++)
+				for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+					memcpy(rgba.data() + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 4, pixels + (y * 4 + x) * 4, 4);
+		}
+	}
+	return true;
+}
+
+bool BcnEncoder::ParseFormat(const char* name, BcFormat& format)
+{
+	static const BcFormat formats[] = { BcFormat::BC1, BcFormat::BC3, BcFormat::BC4, BcFormat::BC5, BcFormat::BC7 };
+	for (BcFormat candidate : formats)
+	{
+		if (strcmp(name, FormatName(candidate)) == 0)
+		{
+			format = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* BcnEncoder::FormatName(BcFormat format)
+{
+	switch (format)
+	{
+	case BcFormat::BC1: return "bc1";
+	case BcFormat::BC3: return "bc3";
+	case BcFormat::BC4: return "bc4";
+	case BcFormat::BC5: return "bc5";
+	default: return "bc7";
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef BCN_ENCODER_H
+#define BCN_ENCODER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// S3TC is an extension to core GL, glad is generated without it
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+enum class BcFormat
+{
+	// RGB, 4 bpp
+	BC1,
+	// RGBA with BC4 style alpha, 8 bpp
+	BC3,
+	// one channel (red), 4 bpp
+	BC4,
+	// two channels (red, green), 8 bpp
+	BC5,
+	// RGBA, 8 bpp, encoded with mode 6 only
+	BC7
+};
+
+// Encodes and decodes 4x4 blocks of RGBA8 pixels. Endpoints come from the
+// principal axis of the block, indices from the nearest palette entry.
+// Whole images are split by block rows across a thread pool.
+class BcnEncoder
+{
+public:
+	// bytes per 4x4 block
+	static size_t BlockSize(BcFormat format);
+	static GLenum GlFormat(BcFormat format, bool srgb);
+	// 16 RGBA pixels in row order
+	static void EncodeBlock(BcFormat format, const unsigned char* rgba, unsigned char* block);
+	// false for BC7 modes other than 6
+	static bool DecodeBlock(BcFormat format, const unsigned char* block, unsigned char* rgba);
+	// RGBA8 image to blocks, edge blocks repeat the last row/column; pool may be null
+	static std::vector<unsigned char> EncodeImage(BcFormat format, const unsigned char* rgba, int width, int height, ThreadPool* pool);
+	// blocks back to RGBA8 (channels the format lacks come back as 0, alpha as 255)
+	static bool DecodeImage(BcFormat format, const unsigned char* blocks, int width, int height, std::vector<unsigned char>& rgba);
+	static bool ParseFormat(const char* name, BcFormat& format);
+	static const char* FormatName(BcFormat format);
+};
+
+#endif
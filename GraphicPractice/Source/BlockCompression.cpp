@@ -0,0 +1,133 @@
+#include "BlockCompression.h"
+
+#include <cstdint>
+#include <cstring>
+
+static const size_t minMatch = 4;
+static const size_t maxOffset = 65535;
+static const int hashBits = 14;
+
+static uint32_t Read32(const char* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static uint32_t HashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - hashBits);
+}
+
+// lengths of 15 and more continue in extra bytes of 255 each plus a remainder
+static void WriteLength(std::vector<char>& out, size_t length)
+{
+	while (length >= 255)
+	{
+		out.push_back((char)255);
+		length -= 255;
+	}
+	out.push_back((char)length);
+}
+
+static void WriteSequence(std::vector<char>& out, const char* literals, size_t literalCount, size_t offset, size_t matchLength)
+{
+	size_t matchCode = matchLength ? matchLength - minMatch : 0;
+	unsigned char token = (unsigned char)(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+	out.push_back((char)token);
+	if (literalCount >= 15)
+		WriteLength(out, literalCount - 15);
+	out.insert(out.end(), literals, literals + literalCount);
+	// the last sequence has literals only
+	if (!matchLength)
+		return;
+	out.push_back((char)(offset & 0xff));
+	out.push_back((char)(offset >> 8));
+	if (matchCode >= 15)
+		WriteLength(out, matchCode - 15);
+}
+
+std::vector<char> BlockCompression::Compress(std::string_view input)
+{
+	std::vector<char> out;
+	out.reserve(input.size() / 2 + 16);
+	std::vector<uint32_t> table((size_t)1 << hashBits, UINT32_MAX);
+	const char* data = input.data();
+	size_t size = input.size();
+	size_t anchor = 0;
+	size_t pos = 0;
+	while (size >= minMatch && pos + minMatch <= size)
+	{
+		uint32_t sequence = Read32(data + pos);
+		uint32_t& slot = table[HashSequence(sequence)];
+		size_t candidate = slot;
+		slot = (uint32_t)pos;
+		if (candidate == UINT32_MAX || pos - candidate > maxOffset || Read32(data + candidate) != sequence)
+		{
+			pos++;
+			continue;
+		}
+		size_t length = minMatch;
+		while (pos + length < size && data[candidate + length] == data[pos + length])
+			length++;
+		WriteSequence(out, data + anchor, pos - anchor, pos - candidate, length);
+		pos += length;
+		anchor = pos;
+	}
+	WriteSequence(out, data + anchor, size - anchor, 0, 0);
+	return out;
+}
+
+static bool ReadLength(const unsigned char*& in, const unsigned char* end, size_t& length)
+{
+	unsigned char byte;
+	do
+	{
+		if (in >= end)
+			return false;
+		byte = *in++;
+		length += byte;
+	} while (byte == 255);
+	return true;
+}
+
+bool BlockCompression::Decompress(std::string_view input, char* output, size_t outputSize)
+{
+	const unsigned char* in = (const unsigned char*)input.data();
+	const unsigned char* end = in + input.size();
+	size_t pos = 0;
+	while (in < end)
+	{
+		unsigned char token = *in++;
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !ReadLength(in, end, literalCount))
+			return false;
+		if (literalCount > (size_t)(end - in) || literalCount > outputSize - pos)
+			return false;
+		memcpy(output + pos, in, literalCount);
+		in += literalCount;
+		pos += literalCount;
+		if (in == end)
+			break;
+
+		if (end - in < 2)
+			return false;
+		size_t offset = in[0] | ((size_t)in[1] << 8);
+		in += 2;
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(in, end, matchLength))
+			return false;
+		matchLength += minMatch;
+		if (offset == 0 || offset > pos || matchLength > outputSize - pos)
+			return false;
+		// overlapping matches repeat the last bytes, so copy forward one byte at a time
+		const char* match = output + pos - offset;
+		if (offset >= matchLength)
+			memcpy(output + pos, match, matchLength);
+		else
+			for (size_t i = 0; i < matchLength; i++)
+				output[pos + i] = match[i];
+		pos += matchLength;
+	}
+	return pos == outputSize;
+}
@@ -0,0 +1,20 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Byte oriented LZ77 in the spirit of LZ4: sequences of a token (literal count
+// and match length nibbles), the literals and a 16 bit match offset. Fast to
+// decode, meant for text like shaders rather than already compressed images.
+class BlockCompression
+{
+public:
+	// compressed bytes, may be larger than the input for incompressible data
+	static std::vector<char> Compress(std::string_view input);
+	// decodes exactly outputSize bytes, false on corrupt input
+	static bool Decompress(std::string_view input, char* output, size_t outputSize);
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "ComputeShader.h"
+#include "ShaderFile.h"
+#include "ShaderPreprocessor.h"
+
+#include <string>
+
+unsigned int ComputeShader::BuildFromFile(const char* computePath)
+{
+	std::string path = computePath;
+	if (path.size() > 7 && path.compare(path.size() - 7, 7, ".shader") == 0)
+	{
+		ShaderFile file;
+		if (!file.Open(path) || file.GetStage(GL_COMPUTE_SHADER).empty())
+		{
+			std::cout << "ERROR::SHADER::COMPUTE::NO_COMPUTE_STAGE " << path << std::endl;
+			return 0;
+		}
+		return BuildProgram({ { GL_COMPUTE_SHADER, file.GetStage(GL_COMPUTE_SHADER) } });
+	}
+	ShaderPreprocessor preprocessor;
+	PreprocessedShader compute = preprocessor.Process(path);
+	if (!compute.success)
+		return 0;
+	return BuildProgram({ { GL_COMPUTE_SHADER, compute.code } });
+}
+
+ComputeShader::ComputeShader(const char* computePath)
+	: ComputeShader(BuildFromFile(computePath))
+{
+}
+
+ComputeShader::ComputeShader(unsigned int programID)
+	: Shader(programID)
+{
+	if (programID != 0)
+		glGetProgramiv(programID, GL_COMPUTE_WORK_GROUP_SIZE, localSize);
+}
+
+void ComputeShader::SetWriteBarriers(GLbitfield barriers)
+{
+	writeBarriers = barriers;
+}
+
+void ComputeShader::Dispatch(unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ)
+{
+	use();
+	Flush();
+	glDispatchCompute(groupsX, groupsY, groupsZ);
+	pendingBarriers |= writeBarriers;
+}
+
+void ComputeShader::DispatchInvocations(unsigned int countX, unsigned int countY, unsigned int countZ)
+{
+	// round up, the shader has to ignore invocations past the end
+	Dispatch((countX + localSize[0] - 1) / localSize[0],
+		(countY + localSize[1] - 1) / localSize[1],
+		(countZ + localSize[2] - 1) / localSize[2]);
+}
+
+void ComputeShader::DispatchIndirect(unsigned int buffer, GLintptr offset)
+{
+	use();
+	Flush();
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffer);
+	glDispatchComputeIndirect(offset);
+	pendingBarriers |= writeBarriers;
+}
+
+void ComputeShader::Barrier()
+{
+	if (pendingBarriers == 0)
+		return;
+	glMemoryBarrier(pendingBarriers);
+	pendingBarriers = 0;
+}
+
+void ComputeShader::BindStorageBuffer(unsigned int binding, unsigned int buffer, GLintptr offset, GLsizeiptr size)
+{
+	if (size > 0)
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, buffer, offset, size);
+	else
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+}
+
+void ComputeShader::BindImage(unsigned int unit, unsigned int texture, GLenum access, GLenum format, int level)
+{
+	glBindImageTexture(unit, texture, level, GL_FALSE, 0, access, format);
+}
@@ -0,0 +1,42 @@
+#ifndef COMPUTE_SHADER_H
+#define COMPUTE_SHADER_H
+
+#include "Shader.h"
+
+// Compute program (GL 4.3) with dispatch helpers, buffer/image bindings
+// and tracking of which writes still need a memory barrier
+class ComputeShader : public Shader
+{
+private:
+	int localSize[3] = { 1, 1, 1 };
+	// barrier bits needed by writes of dispatches that were not synchronized yet
+	GLbitfield pendingBarriers = 0;
+	// barrier bits the next dispatch will make pending
+	GLbitfield writeBarriers = GL_SHADER_STORAGE_BARRIER_BIT;
+	static unsigned int BuildFromFile(const char* computePath);
+public:
+	// plain compute source (with #include support) or a .shader file with a "#shader compute" section
+	explicit ComputeShader(const char* computePath);
+	// already linked compute program
+	explicit ComputeShader(unsigned int programID);
+
+	// local_size declared in the shader
+	const int* GetLocalSize() const { return localSize; }
+	// what the following dispatches write, decides the barrier they need
+	// (e.g. GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT when the output is drawn as vertices)
+	void SetWriteBarriers(GLbitfield barriers);
+	// binds the program and launches the work groups
+	void Dispatch(unsigned int groupsX, unsigned int groupsY = 1, unsigned int groupsZ = 1);
+	// enough work groups to cover the given number of invocations
+	void DispatchInvocations(unsigned int countX, unsigned int countY = 1, unsigned int countZ = 1);
+	// group counts read from a GL_DISPATCH_INDIRECT_BUFFER
+	void DispatchIndirect(unsigned int buffer, GLintptr offset = 0);
+	// issues glMemoryBarrier only if earlier dispatches still have unsynchronized writes
+	void Barrier();
+
+	// whole buffer, or a range of it when size > 0
+	static void BindStorageBuffer(unsigned int binding, unsigned int buffer, GLintptr offset = 0, GLsizeiptr size = 0);
+	static void BindImage(unsigned int unit, unsigned int texture, GLenum access, GLenum format, int level = 0);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include "CpuFeatures.h"
+
+#if defined(CPU_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+bool CpuFeatures::HasSsse3()
+{
+#if defined(CPU_X86) && defined(_MSC_VER)
+	static const bool supported = []()
+	{
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 9)) != 0;
+	}();
+	return supported;
+#elif defined(CPU_X86)
+	return __builtin_cpu_supports("ssse3");
+#else
+	return false;
+#endif
+}
+
+bool CpuFeatures::HasAvx2()
+{
+#if defined(CPU_X86) && defined(_MSC_VER)
+	static const bool supported = []()
+	{
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		// the OS must save the upper halves of the registers as well
+		bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		return osSavesAvx && (info[1] & (1 << 5)) != 0;
+	}();
+	return supported;
+#elif defined(CPU_X86)
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,26 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+// MSVC compiles SSSE3/AVX2 intrinsics without a global /arch switch
+#define CPU_TARGET_SSSE3
+#define CPU_TARGET_AVX2
+#else
+#define CPU_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Runtime checks for the instruction sets the SIMD kernels are built for.
+// SSE2 is always there on x86-64 and needs no check.
+class CpuFeatures
+{
+public:
+	static bool HasSsse3();
+	static bool HasAvx2();
+};
+
+#endif
@@ -0,0 +1,246 @@
+#include "DecodeArena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// malloc's alignment, stb_image's SIMD paths align their own buffers further
+static const size_t alignment = 16;
+static const size_t minimumBlockSize = 1 << 20;
+
+struct ArenaBlock
+{
+	unsigned char* data;
+	size_t size;
+	size_t used;
+};
+
+// a buffer that did not fit the arena, it keeps realloc's in place growth
+// instead of being copied every time stb_image doubles it
+struct LargeAllocation
+{
+	void* data;
+	size_t size;
+};
+
+struct ThreadArena
+{
+	std::vector<ArenaBlock> blocks;
+	std::vector<LargeAllocation> large;
+	bool active = false;
+	std::function<unsigned char*()> allocateOutput;
+	size_t outputSize = 0;
+	// the caller's buffer once it has been handed out
+	unsigned char* output = nullptr;
+	// the only allocation a free or realloc can give back or grow in place
+	unsigned char* last = nullptr;
+	// bytes in use in every block but the last one and in large allocations,
+	// and the most in use at once this scope
+	size_t closedUsed = 0;
+	size_t largeUsed = 0;
+	size_t peakUsed = 0;
+
+	~ThreadArena()
+	{
+		for (ArenaBlock& block : blocks)
+			free(block.data);
+	}
+
+	ArenaBlock* Find(const void* pointer)
+	{
+		const unsigned char* p = (const unsigned char*)pointer;
+		for (ArenaBlock& block : blocks)
+			if (p >= block.data && p < block.data + block.size)
+				return &block;
+		return nullptr;
+	}
+
+	LargeAllocation* FindLarge(const void* pointer)
+	{
+		for (LargeAllocation& allocation : large)
+			if (allocation.data == pointer)
+				return &allocation;
+		return nullptr;
+	}
+
+	void UpdatePeak()
+	{
+		size_t used = blocks.empty() ? 0 : blocks.back().used;
+		peakUsed = std::max(peakUsed, closedUsed + largeUsed + used);
+	}
+};
+
+static thread_local ThreadArena arena;
+
+static size_t RoundUp(size_t size, size_t to)
+{
+	return std::max((size + to - 1) & ~(to - 1), to);
+}
+
+DecodeArena::Scope::Scope()
+{
+	arena.active = true;
+	arena.allocateOutput = nullptr;
+	arena.outputSize = 0;
+	arena.output = nullptr;
+	arena.last = nullptr;
+	arena.closedUsed = 0;
+	arena.largeUsed = 0;
+	arena.peakUsed = 0;
+}
+
+DecodeArena::Scope::~Scope()
+{
+	for (LargeAllocation& allocation : arena.large)
+		free(allocation.data);
+	arena.large.clear();
+	// the next decode gets one block as large as this one used at most (up to
+	// retainLimit), so a run of similar images takes no malloc after the first
+	size_t keep = std::min(RoundUp(arena.peakUsed, minimumBlockSize), retainLimit);
+	if (arena.blocks.size() == 1 && arena.blocks[0].size >= keep)
+		arena.blocks[0].used = 0;
+	else
+	{
+		Release();
+		if (unsigned char* data = (unsigned char*)malloc(keep))
+			arena.blocks.push_back({ data, keep, 0 });
+	}
+	arena.active = false;
+	arena.allocateOutput = nullptr;
+	arena.outputSize = 0;
+	arena.output = nullptr;
+	arena.last = nullptr;
+}
+
+void DecodeArena::Scope::SetOutput(size_t size, std::function<unsigned char*()> allocate)
+{
+	arena.allocateOutput = std::move(allocate);
+	arena.outputSize = size;
+	arena.output = nullptr;
+}
+
+void* DecodeArena::Allocate(size_t size)
+{
+	if (!arena.active)
+		return malloc(size);
+	if (arena.allocateOutput && size == arena.outputSize)
+	{
+		arena.output = arena.allocateOutput();
+		arena.allocateOutput = nullptr;
+		return arena.output;
+	}
+	size_t rounded = RoundUp(size, alignment);
+	if (arena.blocks.empty() || arena.blocks.back().used + rounded > arena.blocks.back().size)
+	{
+		// buffers of a block or more go to malloc, they are touched only as far as
+		// they are written and are given back to the system as soon as they are freed
+		if (rounded >= minimumBlockSize)
+		{
+			void* data = malloc(size);
+			if (data)
+			{
+				arena.large.push_back({ data, size });
+				arena.largeUsed += size;
+				arena.UpdatePeak();
+			}
+			return data;
+		}
+		unsigned char* data = (unsigned char*)malloc(minimumBlockSize);
+		if (!data)
+			return nullptr;
+		if (!arena.blocks.empty())
+			arena.closedUsed += arena.blocks.back().used;
+		arena.blocks.push_back({ data, minimumBlockSize, 0 });
+	}
+	ArenaBlock& block = arena.blocks.back();
+	unsigned char* pointer = block.data + block.used;
+	block.used += rounded;
+	arena.UpdatePeak();
+	arena.last = pointer;
+	return pointer;
+}
+
+void* DecodeArena::Reallocate(void* pointer, size_t oldSize, size_t newSize)
+{
+	if (!pointer)
+		return Allocate(newSize);
+	if (!arena.active)
+		return realloc(pointer, newSize);
+	if (pointer == arena.output && newSize <= arena.outputSize)
+		return pointer;
+	if (LargeAllocation* allocation = arena.FindLarge(pointer))
+	{
+		void* moved = realloc(pointer, newSize);
+		if (moved)
+		{
+			arena.largeUsed = arena.largeUsed - allocation->size + newSize;
+			*allocation = { moved, newSize };
+			arena.UpdatePeak();
+		}
+		return moved;
+	}
+	ArenaBlock* block = arena.Find(pointer);
+	if (!block && pointer != arena.output)
+		return realloc(pointer, newSize);
+	// stb_image grows its zlib buffers by doubling, the latest one usually just extends
+	if (pointer == arena.last && block == &arena.blocks.back())
+	{
+		size_t used = (unsigned char*)pointer - block->data + RoundUp(newSize, alignment);
+		if (used <= block->size)
+		{
+			block->used = used;
+			arena.UpdatePeak();
+			return pointer;
+		}
+	}
+	void* moved = Allocate(newSize);
+	if (moved)
+		memcpy(moved, pointer, std::min(oldSize, newSize));
+	return moved;
+}
+
+void DecodeArena::Free(void* pointer)
+{
+	if (!pointer)
+		return;
+	if (arena.active)
+	{
+		// the caller's buffer is never freed here
+		if (pointer == arena.output)
+			return;
+		if (LargeAllocation* allocation = arena.FindLarge(pointer))
+		{
+			arena.largeUsed -= allocation->size;
+			*allocation = arena.large.back();
+			arena.large.pop_back();
+			free(pointer);
+			return;
+		}
+		if (ArenaBlock* block = arena.Find(pointer))
+		{
+			if (pointer == arena.last)
+			{
+				block->used = (unsigned char*)pointer - block->data;
+				arena.last = nullptr;
+			}
+			return;
+		}
+	}
+	free(pointer);
+}
+
+size_t DecodeArena::GetCapacity()
+{
+	size_t total = 0;
+	for (const ArenaBlock& block : arena.blocks)
+		total += block.size;
+	return total;
+}
+
+void DecodeArena::Release()
+{
+	for (ArenaBlock& block : arena.blocks)
+		free(block.data);
+	arena.blocks.clear();
+}
@@ -0,0 +1,47 @@
+#ifndef DECODE_ARENA_H
+#define DECODE_ARENA_H
+
+#include <cstddef>
+#include <functional>
+
+// Per thread bump allocator behind stb_image's STBI_MALLOC/STBI_REALLOC/STBI_FREE
+// (see stb_image.cpp). Inside a DecodeArena::Scope the decoder's temporary
+// buffers are carved from one block that every decode on the thread reuses,
+// frees only give back the latest allocation and the whole arena is reset when
+// the scope ends. A thread keeps one block of retainLimit bytes between
+// decodes, which holds the small temporaries (Huffman tables, row buffers);
+// buffers of a block or more come from malloc and go back right away, so the
+// workers stay no larger than with plain malloc. TextureLoader releases the
+// arenas once the pool drains with no decode left (see ThreadPool::SetIdleTask).
+// Outside a scope the hooks are plain malloc/realloc/free.
+class DecodeArena
+{
+public:
+	static constexpr size_t retainLimit = 1 << 20;
+
+	// One decode on this thread, anything stb_image returns inside it is only
+	// valid until the scope ends
+	class Scope
+	{
+	public:
+		Scope();
+		~Scope();
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		// the first allocation of exactly size bytes is taken from allocate instead of
+		// the arena, so the decoded pixels land in the caller's buffer; it is called
+		// when stb_image gets there, the buffer is not held during the whole decode
+		void SetOutput(size_t size, std::function<unsigned char*()> allocate);
+	};
+
+	static void* Allocate(size_t size);
+	static void* Reallocate(void* pointer, size_t oldSize, size_t newSize);
+	static void Free(void* pointer);
+	// bytes this thread's arena holds on to between decodes
+	static size_t GetCapacity();
+	// frees this thread's arena (not inside a scope), the next decode starts from nothing
+	static void Release();
+};
+
+#endif
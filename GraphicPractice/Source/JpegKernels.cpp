@@ -0,0 +1,177 @@
+#include "JpegKernels.h"
+#include "CpuFeatures.h"
+
+#include <atomic>
+
+static std::atomic<bool> enabled(true);
+
+#ifdef CPU_X86
+// stb_image's fixed point constants, see stbi__float2fixed
+static int FloatToFixed(float x)
+{
+	return (int)(x * 4096.0f + 0.5f);
+}
+
+// stb_image's reduced precision conversion, the scalar tail must match it bit for bit
+static void ColorScalar(unsigned char* out, const unsigned char* y, const unsigned char* cb, const unsigned char* cr, int count, int step)
+{
+	for (int i = 0; i < count; i++)
+	{
+		int yFixed = (y[i] << 20) + (1 << 19);
+		int crValue = cr[i] - 128;
+		int cbValue = cb[i] - 128;
+		int r = yFixed + crValue * (FloatToFixed(1.40200f) << 8);
+		int g = yFixed + crValue * -(FloatToFixed(0.71414f) << 8) + ((cbValue * -(FloatToFixed(0.34414f) << 8)) & 0xffff0000);
+		int b = yFixed + cbValue * (FloatToFixed(1.77200f) << 8);
+		r >>= 20;
+		g >>= 20;
+		b >>= 20;
+		out[0] = (unsigned char)(r < 0 ? 0 : r > 255 ? 255 : r);
+		out[1] = (unsigned char)(g < 0 ? 0 : g > 255 ? 255 : g);
+		out[2] = (unsigned char)(b < 0 ? 0 : b > 255 ? 255 : b);
+		out[3] = 255;
+		out += step;
+	}
+}
+
+CPU_TARGET_AVX2 static void ColorAvx2(unsigned char* out, const unsigned char* y, const unsigned char* cb, const unsigned char* cr, int count, int step)
+{
+	int i = 0;
+	// RGB output is written 16 bytes per 4 pixels, so it stops while at least
+	// two more pixels are left to take the overhang
+	if (step == 4 || step == 3)
+	{
+		const int overhang = step == 4 ? 0 : 2;
+		const __m256i dropAlpha = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+			0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		const __m128i signFlip = _mm_set1_epi8(-0x80);
+		const __m256i crConst0 = _mm256_set1_epi16((short)(1.40200f * 4096.0f + 0.5f));
+		const __m256i crConst1 = _mm256_set1_epi16(-(short)(0.71414f * 4096.0f + 0.5f));
+		const __m256i cbConst0 = _mm256_set1_epi16(-(short)(0.34414f * 4096.0f + 0.5f));
+		const __m256i cbConst1 = _mm256_set1_epi16((short)(1.77200f * 4096.0f + 0.5f));
+		const __m256i yBias = _mm256_set1_epi16(128);
+		const __m256i alpha = _mm256_set1_epi16(255);
+		for (; i + 15 + overhang < count; i += 16)
+		{
+			// 16 bit lanes hold the value in the high byte, as stb_image's unpack does
+			__m256i yw = _mm256_or_si256(_mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(y + i))), 8), yBias);
+			__m256i crw = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_xor_si128(_mm_loadu_si128((const __m128i*)(cr + i)), signFlip)), 8);
+			__m256i cbw = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_xor_si128(_mm_loadu_si128((const __m128i*)(cb + i)), signFlip)), 8);
+
+			__m256i yws = _mm256_srli_epi16(yw, 4);
+			__m256i rws = _mm256_add_epi16(_mm256_mulhi_epi16(crConst0, crw), yws);
+			__m256i gws = _mm256_add_epi16(_mm256_add_epi16(_mm256_mulhi_epi16(cbConst0, cbw), yws), _mm256_mulhi_epi16(crw, crConst1));
+			__m256i bws = _mm256_add_epi16(yws, _mm256_mulhi_epi16(cbw, cbConst1));
+			__m256i rw = _mm256_srai_epi16(rws, 4);
+			__m256i gw = _mm256_srai_epi16(gws, 4);
+			__m256i bw = _mm256_srai_epi16(bws, 4);
+
+			// per lane interleave gives pixels 0-3/8-11 and 4-7/12-15
+			__m256i rb = _mm256_packus_epi16(rw, bw);
+			__m256i ga = _mm256_packus_epi16(gw, alpha);
+			__m256i rg = _mm256_unpacklo_epi8(rb, ga);
+			__m256i ba = _mm256_unpackhi_epi8(rb, ga);
+			__m256i o0 = _mm256_unpacklo_epi16(rg, ba);
+			__m256i o1 = _mm256_unpackhi_epi16(rg, ba);
+			if (step == 4)
+			{
+				_mm256_storeu_si256((__m256i*)out, _mm256_permute2x128_si256(o0, o1, 0x20));
+				_mm256_storeu_si256((__m256i*)(out + 32), _mm256_permute2x128_si256(o0, o1, 0x31));
+			}
+			else
+			{
+				// in pixel order, each store overwrites the previous one's 4 spare bytes
+				__m256i rgb0 = _mm256_shuffle_epi8(o0, dropAlpha);
+				__m256i rgb1 = _mm256_shuffle_epi8(o1, dropAlpha);
+				_mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(rgb0));
+				_mm_storeu_si128((__m128i*)(out + 12), _mm256_castsi256_si128(rgb1));
+				_mm_storeu_si128((__m128i*)(out + 24), _mm256_extracti128_si256(rgb0, 1));
+				_mm_storeu_si128((__m128i*)(out + 36), _mm256_extracti128_si256(rgb1, 1));
+			}
+			out += 16 * step;
+		}
+		_mm256_zeroupper();
+	}
+	ColorScalar(out, y + i, cb + i, cr + i, count - i, step);
+}
+
+CPU_TARGET_AVX2 static unsigned char* ResampleAvx2(unsigned char* out, unsigned char* inNear, unsigned char* inFar, int width, int hs)
+{
+	(void)hs;
+	if (width == 1)
+	{
+		out[0] = out[1] = (unsigned char)((3 * inNear[0] + inFar[0] + 2) >> 2);
+		return out;
+	}
+
+	int i = 0;
+	int t1 = 3 * inNear[0] + inFar[0];
+	const __m256i bias = _mm256_set1_epi16(8);
+	// 16 input pixels per step, the last pixel of the row needs the edge rule
+	for (; i < ((width - 1) & ~15); i += 16)
+	{
+		// vertical pass, 3 * near + far
+		__m256i farw = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(inFar + i)));
+		__m256i nearw = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(inNear + i)));
+		__m256i curr = _mm256_add_epi16(_mm256_slli_epi16(nearw, 2), _mm256_sub_epi16(farw, nearw));
+
+		// neighbours one pixel to either side, shifted across the lane boundary
+		__m256i prev = _mm256_alignr_epi8(curr, _mm256_permute2x128_si256(curr, curr, 0x08), 14);
+		__m256i next = _mm256_alignr_epi8(_mm256_permute2x128_si256(curr, curr, 0x81), curr, 2);
+		prev = _mm256_insert_epi16(prev, (short)t1, 0);
+		next = _mm256_insert_epi16(next, (short)(3 * inNear[i + 16] + inFar[i + 16]), 15);
+
+		// even = 3 * curr + prev, odd = 3 * curr + next
+		__m256i currBiased = _mm256_add_epi16(_mm256_slli_epi16(curr, 2), bias);
+		__m256i even = _mm256_add_epi16(_mm256_sub_epi16(prev, curr), currBiased);
+		__m256i odd = _mm256_add_epi16(_mm256_sub_epi16(next, curr), currBiased);
+		__m256i low = _mm256_srli_epi16(_mm256_unpacklo_epi16(even, odd), 4);
+		__m256i high = _mm256_srli_epi16(_mm256_unpackhi_epi16(even, odd), 4);
+		_mm256_storeu_si256((__m256i*)(out + i * 2), _mm256_packus_epi16(low, high));
+
+		t1 = 3 * inNear[i + 15] + inFar[i + 15];
+	}
+	_mm256_zeroupper();
+
+	int t0 = t1;
+	t1 = 3 * inNear[i] + inFar[i];
+	out[i * 2] = (unsigned char)((3 * t1 + t0 + 8) >> 4);
+	for (++i; i < width; ++i)
+	{
+		t0 = t1;
+		t1 = 3 * inNear[i] + inFar[i];
+		out[i * 2 - 1] = (unsigned char)((3 * t0 + t1 + 8) >> 4);
+		out[i * 2] = (unsigned char)((3 * t1 + t0 + 8) >> 4);
+	}
+	out[width * 2 - 1] = (unsigned char)((t1 + 2) >> 2);
+	return out;
+}
+#endif
+
+void JpegKernels::Install(ColorKernel& color, ResampleKernel& resample)
+{
+#ifdef CPU_X86
+	if (IsActive())
+	{
+		color = ColorAvx2;
+		resample = ResampleAvx2;
+	}
+#else
+	(void)color;
+	(void)resample;
+#endif
+}
+
+void JpegKernels::SetEnabled(bool value)
+{
+	enabled = value;
+}
+
+bool JpegKernels::IsActive()
+{
+#ifdef CPU_X86
+	return enabled && CpuFeatures::HasAvx2();
+#else
+	return false;
+#endif
+}
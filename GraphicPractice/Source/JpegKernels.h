@@ -0,0 +1,23 @@
+#ifndef JPEG_KERNELS_H
+#define JPEG_KERNELS_H
+
+// AVX2 versions of the stb_image JPEG color conversion (RGB and RGBA output)
+// and 2x2 chroma upsampler, giving the same bytes as stb_image's own. The
+// IDCT stays on stb_image's SSE2 kernel: it gets one 8x8 block per call and
+// its transposes keep a wider version from being any faster.
+// stb_image.cpp hands them to the decoder through STBI_JPEG_KERNEL_HOOK,
+// CPUs without AVX2 keep the vendored set.
+class JpegKernels
+{
+public:
+	typedef void (*ColorKernel)(unsigned char* out, const unsigned char* y, const unsigned char* cb, const unsigned char* cr, int count, int step);
+	typedef unsigned char* (*ResampleKernel)(unsigned char* out, unsigned char* inNear, unsigned char* inFar, int width, int hs);
+
+	// called for every decode, replaces the kernels when AVX2 is there and enabled
+	static void Install(ColorKernel& color, ResampleKernel& resample);
+	// on by default, off compares against stb_image's own kernels
+	static void SetEnabled(bool enabled);
+	static bool IsActive();
+};
+
+#endif
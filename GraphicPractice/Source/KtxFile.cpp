@@ -0,0 +1,229 @@
+#include "KtxFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static const unsigned char ktxIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+// level data offsets are kept on a multiple of the largest block size
+static const size_t levelAlignment = 16;
+
+struct KtxHeader
+{
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+};
+
+struct KtxLevel
+{
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+};
+
+// one row per format: Vulkan format (linear, sRGB), data format descriptor color model, channels
+struct KtxFormat
+{
+	BcFormat format;
+	uint32_t vkFormat;
+	uint32_t vkFormatSrgb;
+	uint8_t colorModel;
+	int channels;
+};
+
+static const KtxFormat ktxFormats[] = {
+	{ BcFormat::BC1, 131, 132, 128, 3 },
+	{ BcFormat::BC3, 137, 138, 130, 4 },
+	{ BcFormat::BC4, 139, 139, 131, 1 },
+	{ BcFormat::BC5, 141, 141, 132, 2 },
+	{ BcFormat::BC7, 145, 146, 134, 4 },
+};
+
+static const KtxFormat* FindFormat(BcFormat format)
+{
+	for (const KtxFormat& entry : ktxFormats)
+		if (entry.format == format)
+			return &entry;
+	return nullptr;
+}
+
+static size_t AlignLevel(size_t offset)
+{
+	return (offset + levelAlignment - 1) & ~(levelAlignment - 1);
+}
+
+static void Append(std::vector<unsigned char>& out, const void* data, size_t size)
+{
+	out.insert(out.end(), (const unsigned char*)data, (const unsigned char*)data + size);
+}
+
+// basic data format descriptor, one sample per 64 bit half of the block
+static std::vector<unsigned char> MakeDescriptor(const KtxFormat& format, bool srgb)
+{
+	// (bit offset, channel id) of every sample
+	std::vector<std::pair<uint16_t, uint8_t>> samples;
+	switch (format.format)
+	{
+	case BcFormat::BC3: samples = { { 0, 15 }, { 64, 0 } }; break;
+	case BcFormat::BC5: samples = { { 0, 0 }, { 64, 1 } }; break;
+	default: samples = { { 0, 0 } }; break;
+	}
+	size_t blockSize = BcnEncoder::BlockSize(format.format);
+	uint8_t sampleBits = (uint8_t)(format.format == BcFormat::BC7 ? 127 : 63);
+
+	std::vector<unsigned char> out;
+	uint16_t blockBytes = (uint16_t)(24 + 16 * samples.size());
+	uint32_t totalSize = 4 + blockBytes;
+	uint32_t vendorAndType = 0;
+	uint16_t version = 2;
+	Append(out, &totalSize, 4);
+	Append(out, &vendorAndType, 4);
+	Append(out, &version, 2);
+	Append(out, &blockBytes, 2);
+	uint8_t model[4] = { format.colorModel, 1, (uint8_t)(srgb ? 2 : 1), 0 };
+	Append(out, model, 4);
+	uint8_t blockDimensions[4] = { 3, 3, 0, 0 };
+	Append(out, blockDimensions, 4);
+	uint8_t bytesPlane[8] = { (uint8_t)blockSize };
+	Append(out, bytesPlane, 8);
+	for (const auto& sample : samples)
+	{
+		uint8_t position[4] = {};
+		uint32_t lower = 0, upper = 0xffffffffu;
+		Append(out, &sample.first, 2);
+		Append(out, &sampleBits, 1);
+		Append(out, &sample.second, 1);
+		Append(out, position, 4);
+		Append(out, &lower, 4);
+		Append(out, &upper, 4);
+	}
+	return out;
+}
+
+bool KtxFile::Write(const std::string& path, BcFormat format, bool srgb, const TextureImage& image)
+{
+	const KtxFormat* entry = FindFormat(format);
+	if (!entry || image.levels.empty())
+		return false;
+	std::vector<unsigned char> descriptor = MakeDescriptor(*entry, srgb);
+	size_t levelCount = image.levels.size();
+
+	KtxHeader header = {};
+	header.vkFormat = srgb ? entry->vkFormatSrgb : entry->vkFormat;
+	header.typeSize = 1;
+	header.pixelWidth = image.width;
+	header.pixelHeight = image.height;
+	header.faceCount = 1;
+	header.levelCount = (uint32_t)levelCount;
+	header.dfdByteOffset = (uint32_t)(sizeof(ktxIdentifier) + sizeof(header) + levelCount * sizeof(KtxLevel));
+	header.dfdByteLength = (uint32_t)descriptor.size();
+
+	// smallest level first in the file, the index stays in level order
+	std::vector<KtxLevel> levels(levelCount);
+	size_t offset = AlignLevel(header.dfdByteOffset + header.dfdByteLength);
+	for (size_t i = levelCount; i-- > 0;)
+	{
+		levels[i].byteOffset = offset;
+		levels[i].byteLength = image.levels[i].size;
+		levels[i].uncompressedByteLength = image.levels[i].size;
+		offset = AlignLevel(offset + image.levels[i].size);
+	}
+
+	std::vector<unsigned char> out;
+	Append(out, ktxIdentifier, sizeof(ktxIdentifier));
+	Append(out, &header, sizeof(header));
+	Append(out, levels.data(), levels.size() * sizeof(KtxLevel));
+	Append(out, descriptor.data(), descriptor.size());
+	for (size_t i = levelCount; i-- > 0;)
+	{
+		out.resize((size_t)levels[i].byteOffset, 0);
+		Append(out, image.GetLevelData(i), image.levels[i].size);
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "ERROR::KTX::CANNOT_WRITE " << path << std::endl;
+		return false;
+	}
+	file.write((const char*)out.data(), out.size());
+	return (bool)file;
+}
+
+bool KtxFile::IsKtx2(std::string_view data)
+{
+	return data.size() >= sizeof(ktxIdentifier) && memcmp(data.data(), ktxIdentifier, sizeof(ktxIdentifier)) == 0;
+}
+
+bool KtxFile::Parse(std::string_view data, TextureImage& image)
+{
+	KtxHeader header;
+	if (!IsKtx2(data) || data.size() < sizeof(ktxIdentifier) + sizeof(header))
+		return false;
+	memcpy(&header, data.data() + sizeof(ktxIdentifier), sizeof(header));
+	const KtxFormat* entry = nullptr;
+	bool srgb = false;
+	for (const KtxFormat& candidate : ktxFormats)
+	{
+		if (header.vkFormat == candidate.vkFormat || header.vkFormat == candidate.vkFormatSrgb)
+		{
+			entry = &candidate;
+			srgb = header.vkFormat == candidate.vkFormatSrgb && candidate.vkFormat != candidate.vkFormatSrgb;
+		}
+	}
+	// arrays, cube maps, 3D textures and supercompressed files are not used here
+	if (!entry || header.supercompressionScheme != 0 || header.pixelDepth > 1 || header.layerCount > 1 ||
+		header.faceCount != 1 || header.pixelWidth == 0 || header.pixelHeight == 0)
+	{
+		std::cout << "ERROR::KTX::UNSUPPORTED vkFormat " << header.vkFormat << std::endl;
+		return false;
+	}
+	size_t levelCount = std::max(header.levelCount, 1u);
+	size_t indexOffset = sizeof(ktxIdentifier) + sizeof(header);
+	if (levelCount > 32 || data.size() < indexOffset + levelCount * sizeof(KtxLevel))
+		return false;
+
+	size_t blockSize = BcnEncoder::BlockSize(entry->format);
+	image.file.Close();
+	image.storage.clear();
+	image.levels.clear();
+	for (size_t i = 0; i < levelCount; i++)
+	{
+		KtxLevel level;
+		memcpy(&level, data.data() + indexOffset + i * sizeof(KtxLevel), sizeof(level));
+		TextureLevel target;
+		target.width = std::max((int)(header.pixelWidth >> i), 1);
+		target.height = std::max((int)(header.pixelHeight >> i), 1);
+		target.size = (size_t)((target.width + 3) / 4) * ((target.height + 3) / 4) * blockSize;
+		if (level.byteLength != target.size || level.byteOffset > data.size() || level.byteLength > data.size() - level.byteOffset)
+		{
+			std::cout << "ERROR::KTX::INVALID_LEVEL " << i << std::endl;
+			return false;
+		}
+		target.offset = image.storage.size();
+		image.storage.insert(image.storage.end(), data.data() + level.byteOffset, data.data() + level.byteOffset + level.byteLength);
+		image.levels.push_back(target);
+	}
+	image.width = header.pixelWidth;
+	image.height = header.pixelHeight;
+	image.channels = entry->channels;
+	image.bgra = false;
+	image.compressedFormat = BcnEncoder::GlFormat(entry->format, srgb);
+	return true;
+}
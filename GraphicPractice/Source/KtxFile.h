@@ -0,0 +1,22 @@
+#ifndef KTX_FILE_H
+#define KTX_FILE_H
+
+#include "BcnEncoder.h"
+#include "TextureImage.h"
+
+#include <string>
+#include <string_view>
+
+// KTX2 container for BCn textures with a full or partial mip chain, no
+// supercompression. Levels are stored smallest first as the format asks.
+class KtxFile
+{
+public:
+	// image holds the blocks of every level, level 0 first
+	static bool Write(const std::string& path, BcFormat format, bool srgb, const TextureImage& image);
+	static bool IsKtx2(std::string_view data);
+	// copies the levels into image and sets its compressedFormat, false for formats GL has no name for
+	static bool Parse(std::string_view data, TextureImage& image);
+};
+
+#endif
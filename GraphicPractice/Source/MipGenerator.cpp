@@ -0,0 +1,226 @@
+#include "MipGenerator.h"
+#include "CpuFeatures.h"
+#include "TextureImage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const int kaiserTaps = 8;
+static const int encodeTableSize = 4096;
+
+struct FilterTaps
+{
+	int count;
+	// source offset of every tap from 2 * destination index
+	int offsets[kaiserTaps];
+	float weights[kaiserTaps];
+};
+
+static float SrgbToLinear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSrgb(float value)
+{
+	return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// byte -> linear float for sRGB and plain channels
+static const float* DecodeTable(bool srgb)
+{
+	static const std::vector<float> tables = []()
+	{
+		std::vector<float> values(512);
+		for (int i = 0; i < 256; i++)
+		{
+			values[i] = i / 255.0f;
+			values[256 + i] = SrgbToLinear(i / 255.0f);
+		}
+		return values;
+	}();
+	return tables.data() + (srgb ? 256 : 0);
+}
+
+// linear float quantized to encodeTableSize steps -> sRGB byte
+static const unsigned char* EncodeTable()
+{
+	static const std::vector<unsigned char> table = []()
+	{
+		std::vector<unsigned char> values(encodeTableSize);
+		for (int i = 0; i < encodeTableSize; i++)
+			values[i] = (unsigned char)std::lround(LinearToSrgb(i / (float)(encodeTableSize - 1)) * 255.0f);
+		return values;
+	}();
+	return table.data();
+}
+
+static double BesselI0(double x)
+{
+	// power series, converges fast for the small arguments used here
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; k++)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+static FilterTaps MakeTaps(MipFilter filter)
+{
+	FilterTaps taps = {};
+	if (filter == MipFilter::Box)
+	{
+		taps.count = 2;
+		taps.offsets[0] = 0;
+		taps.offsets[1] = 1;
+		taps.weights[0] = taps.weights[1] = 0.5f;
+		return taps;
+	}
+	// sinc windowed over two destination texels each side, source texel 2x + k sits (k - 0.5) / 2 away
+	const double alpha = 4.0, radius = 2.0, pi = 3.14159265358979323846;
+	double total = 0.0;
+	double weights[kaiserTaps];
+	taps.count = kaiserTaps;
+	for (int i = 0; i < kaiserTaps; i++)
+	{
+		int k = i - 3;
+		double t = (k - 0.5) / 2.0;
+		double sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+		double ratio = t / radius;
+		double window = BesselI0(alpha * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / BesselI0(alpha);
+		weights[i] = sinc * window;
+		taps.offsets[i] = k;
+		total += weights[i];
+	}
+	for (int i = 0; i < kaiserTaps; i++)
+		taps.weights[i] = (float)(weights[i] / total);
+	return taps;
+}
+
+// out[i] = sum of weights[k] * rows[k][i]
+static void WeightRowsScalar(const float* const* rows, const float* weights, int count, float* out, size_t from, size_t n)
+{
+	for (size_t i = from; i < n; i++)
+	{
+		float sum = 0.0f;
+		for (int k = 0; k < count; k++)
+			sum += weights[k] * rows[k][i];
+		out[i] = sum;
+	}
+}
+
+#ifdef CPU_X86
+static void WeightRowsSse2(const float* const* rows, const float* weights, int count, float* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (int k = 0; k < count; k++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+		_mm_storeu_ps(out + i, sum);
+	}
+	WeightRowsScalar(rows, weights, count, out, i, n);
+}
+
+CPU_TARGET_AVX2 static void WeightRowsAvx2(const float* const* rows, const float* weights, int count, float* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 sum = _mm256_setzero_ps();
+		for (int k = 0; k < count; k++)
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i)));
+		_mm256_storeu_ps(out + i, sum);
+	}
+	WeightRowsScalar(rows, weights, count, out, i, n);
+}
+#endif
+
+static void WeightRows(const float* const* rows, const float* weights, int count, float* out, size_t n)
+{
+#ifdef CPU_X86
+	static const bool avx2 = CpuFeatures::HasAvx2();
+	if (avx2)
+		WeightRowsAvx2(rows, weights, count, out, n);
+	else
+		WeightRowsSse2(rows, weights, count, out, n);
+#else
+	WeightRowsScalar(rows, weights, count, out, 0, n);
+#endif
+}
+
+void MipGenerator::Build(TextureImage& image, MipFilter filter, bool srgb)
+{
+	if (image.levels.empty() || image.file.IsOpen())
+		return;
+	image.levels.resize(1);
+	image.storage.resize(image.levels[0].size);
+	int channels = image.channels;
+	// alpha is the last channel of grey-alpha and RGBA images
+	bool hasAlpha = channels == 2 || channels == 4;
+	bool encoded[4];
+	for (int c = 0; c < 4; c++)
+		encoded[c] = srgb && !(hasAlpha && c == channels - 1);
+
+	int width = image.width;
+	int height = image.height;
+	std::vector<float> current((size_t)width * height * channels);
+	for (size_t i = 0; i < current.size(); i++)
+		current[i] = DecodeTable(encoded[i % channels])[image.storage[i]];
+
+	FilterTaps taps = MakeTaps(filter);
+	const unsigned char* encodeTable = EncodeTable();
+	std::vector<float> next;
+	std::vector<float> column((size_t)width * channels);
+	image.storage.reserve(image.levels[0].size + image.levels[0].size / 3 + 16 * channels);
+	while (width > 1 || height > 1)
+	{
+		int nextWidth = std::max(width / 2, 1);
+		int nextHeight = std::max(height / 2, 1);
+		size_t rowFloats = (size_t)width * channels;
+		next.resize((size_t)nextWidth * nextHeight * channels);
+		for (int y = 0; y < nextHeight; y++)
+		{
+			// vertical taps over whole rows, edges clamp (this also covers odd sizes)
+			const float* rows[kaiserTaps];
+			for (int k = 0; k < taps.count; k++)
+				rows[k] = current.data() + (size_t)std::min(std::max(y * 2 + taps.offsets[k], 0), height - 1) * rowFloats;
+			WeightRows(rows, taps.weights, taps.count, column.data(), rowFloats);
+
+			float* out = next.data() + (size_t)y * nextWidth * channels;
+			for (int x = 0; x < nextWidth; x++)
+			{
+				for (int c = 0; c < channels; c++)
+				{
+					float sum = 0.0f;
+					for (int k = 0; k < taps.count; k++)
+						sum += taps.weights[k] * column[(size_t)std::min(std::max(x * 2 + taps.offsets[k], 0), width - 1) * channels + c];
+					out[x * channels + c] = sum;
+				}
+			}
+		}
+
+		TextureLevel level;
+		level.width = nextWidth;
+		level.height = nextHeight;
+		level.offset = image.storage.size();
+		level.size = next.size();
+		image.storage.resize(level.offset + level.size);
+		unsigned char* bytes = image.storage.data() + level.offset;
+		for (size_t i = 0; i < next.size(); i++)
+		{
+			// the sinc lobes overshoot at hard edges
+			float value = std::min(std::max(next[i], 0.0f), 1.0f);
+			bytes[i] = encoded[i % channels] ? encodeTable[(int)(value * (encodeTableSize - 1) + 0.5f)]
+				: (unsigned char)(value * 255.0f + 0.5f);
+		}
+		image.levels.push_back(level);
+		current.swap(next);
+		width = nextWidth;
+		height = nextHeight;
+	}
+}
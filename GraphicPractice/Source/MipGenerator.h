@@ -0,0 +1,25 @@
+#ifndef MIP_GENERATOR_H
+#define MIP_GENERATOR_H
+
+struct TextureImage;
+
+enum class MipFilter
+{
+	// 2x2 average, cheapest
+	Box,
+	// 8 tap windowed sinc, keeps more detail without aliasing
+	Kaiser
+};
+
+// Builds mip chains on the CPU so the driver never has to. Levels are
+// filtered as floats in linear light (color channels are decoded from sRGB
+// when asked, alpha never is) and every level is made from the unrounded
+// previous one. The vertical pass runs on SSE2, or AVX2 when the CPU has it.
+class MipGenerator
+{
+public:
+	// replaces everything below level 0 of an image held in storage
+	static void Build(TextureImage& image, MipFilter filter, bool srgb);
+};
+
+#endif
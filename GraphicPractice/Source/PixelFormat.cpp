@@ -0,0 +1,73 @@
+#include "PixelFormat.h"
+#include "PixelKernels.h"
+#include "TextureImage.h"
+
+// three byte texels are padded by most drivers, so expanding on the loader threads is the safe default
+bool PixelFormats::expandRgb = true;
+bool PixelFormats::preferBgra = false;
+
+void PixelFormats::QueryDriverPreferences()
+{
+	// these queries are 4.3 (glad loads no extensions), older contexts keep the defaults
+	if (!GLAD_GL_VERSION_4_3)
+		return;
+	GLint preferred = GL_NONE;
+	glGetInternalformativ(GL_TEXTURE_2D, GL_RGB8, GL_INTERNALFORMAT_PREFERRED, 1, &preferred);
+	// GL_NONE when the driver has no answer, keep the default then
+	if (preferred != GL_NONE)
+		expandRgb = preferred != GL_RGB8;
+	GLint format = GL_NONE;
+	glGetInternalformativ(GL_TEXTURE_2D, GL_RGBA8, GL_TEXTURE_IMAGE_FORMAT, 1, &format);
+	preferBgra = format == GL_BGRA;
+}
+
+PixelFormat PixelFormats::ForImage(const TextureImage& image)
+{
+	switch (image.channels)
+	{
+	case 1: return { GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1 };
+	case 2: return { GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2 };
+	case 3: return { GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3 };
+	default:
+		// BGRA with the packed type is the layout drivers copy straight into the texture
+		if (image.bgra)
+			return { GL_RGBA8, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, 4 };
+		return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 };
+	}
+}
+
+void PixelFormats::Convert(TextureImage& image, bool premultiplyAlpha)
+{
+	if (image.file.IsOpen() || image.levels.empty())
+		return;
+	size_t total = image.GetTotalSize();
+	bool opaque = image.channels == 3;
+	if (image.channels == 3 && expandRgb)
+	{
+		PixelStorage expanded(total / 3 * 4);
+		PixelKernels::ExpandRgbToRgba(image.storage.data(), expanded.data(), total / 3);
+		image.storage.swap(expanded);
+		for (TextureLevel& level : image.levels)
+		{
+			level.offset = level.offset / 3 * 4;
+			level.size = level.size / 3 * 4;
+		}
+		image.channels = 4;
+		total = total / 3 * 4;
+	}
+	if (image.channels != 4)
+		return;
+	if (premultiplyAlpha && !opaque)
+		PixelKernels::PremultiplyAlpha(image.storage.data(), total / 4);
+	if (preferBgra && !image.bgra)
+	{
+		PixelKernels::SwapRedBlue(image.storage.data(), total / 4);
+		image.bgra = true;
+	}
+}
+
+std::string PixelFormats::Variant(bool premultiplyAlpha)
+{
+	return std::string("expand=") + (expandRgb ? "1" : "0") + " bgra=" + (preferBgra ? "1" : "0") +
+		" premultiplied=" + (premultiplyAlpha ? "1" : "0");
+}
@@ -0,0 +1,40 @@
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <glad/glad.h>
+
+#include <string>
+
+struct TextureImage;
+
+// How an image is handed to glTex(Sub)Image
+struct PixelFormat
+{
+	GLenum internalFormat;
+	GLenum format;
+	GLenum type;
+	// bytes per pixel as uploaded
+	int channels;
+};
+
+// Picks upload formats from the decoded channel count and what the driver
+// copies without conversion, and converts images into that layout
+class PixelFormats
+{
+private:
+	static bool expandRgb;
+	static bool preferBgra;
+public:
+	// asks the driver for its preferred layouts (GL 4.3 internal format queries, the
+	// defaults stay on older contexts), render thread
+	static void QueryDriverPreferences();
+	// describes the image in its current layout
+	static PixelFormat ForImage(const TextureImage& image);
+	// converts the image to the layout the driver prefers, optionally premultiplying alpha
+	// (4 channel images only); run it before building mips
+	static void Convert(TextureImage& image, bool premultiplyAlpha);
+	// everything Convert depends on, for cache keys
+	static std::string Variant(bool premultiplyAlpha);
+};
+
+#endif
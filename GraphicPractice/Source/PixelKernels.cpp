@@ -0,0 +1,162 @@
+#include "PixelKernels.h"
+#include "CpuFeatures.h"
+
+#include <utility>
+
+static void ExpandScalar(const unsigned char* src, unsigned char* dst, size_t pixels)
+{
+	for (size_t i = 0; i < pixels; i++)
+	{
+		dst[i * 4 + 0] = src[i * 3 + 0];
+		dst[i * 4 + 1] = src[i * 3 + 1];
+		dst[i * 4 + 2] = src[i * 3 + 2];
+		dst[i * 4 + 3] = 255;
+	}
+}
+
+static void SwapScalar(unsigned char* pixels, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		std::swap(pixels[i * 4], pixels[i * 4 + 2]);
+}
+
+static void PremultiplyScalar(unsigned char* pixels, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		unsigned int alpha = pixels[i * 4 + 3];
+		for (int c = 0; c < 3; c++)
+		{
+			// exact division by 255 with rounding
+			unsigned int t = pixels[i * 4 + c] * alpha + 128;
+			pixels[i * 4 + c] = (unsigned char)((t + (t >> 8)) >> 8);
+		}
+	}
+}
+
+#ifdef CPU_X86
+CPU_TARGET_SSSE3 static size_t ExpandSsse3(const unsigned char* src, unsigned char* dst, size_t pixels)
+{
+	// 16 pixels per step: three 16 byte loads become four 16 byte stores
+	const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+	size_t i = 0;
+	for (; i + 16 <= pixels; i += 16)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(src + i * 3));
+		__m128i b = _mm_loadu_si128((const __m128i*)(src + i * 3 + 16));
+		__m128i c = _mm_loadu_si128((const __m128i*)(src + i * 3 + 32));
+		_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(a, spread), alpha));
+		_mm_storeu_si128((__m128i*)(dst + i * 4 + 16), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), spread), alpha));
+		_mm_storeu_si128((__m128i*)(dst + i * 4 + 32), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), spread), alpha));
+		_mm_storeu_si128((__m128i*)(dst + i * 4 + 48), _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), spread), alpha));
+	}
+	return i;
+}
+
+CPU_TARGET_SSSE3 static size_t SwapSsse3(unsigned char* pixels, size_t count)
+{
+	const __m128i order = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i* p = (__m128i*)(pixels + i * 4);
+		_mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), order));
+	}
+	return i;
+}
+
+CPU_TARGET_AVX2 static size_t SwapAvx2(unsigned char* pixels, size_t count)
+{
+	// the shuffle works per 128 bit lane, so the pattern repeats
+	const __m256i order = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i* p = (__m256i*)(pixels + i * 4);
+		_mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), order));
+	}
+	return i;
+}
+
+static __m128i PremultiplyHalf(__m128i color)
+{
+	// alpha of each pixel into all four of its 16 bit lanes, alpha itself is multiplied by 255
+	__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(color, 0xff), 0xff);
+	const __m128i alphaLanes = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+	alpha = _mm_or_si128(_mm_andnot_si128(alphaLanes, alpha), _mm_and_si128(alphaLanes, _mm_set1_epi16(255)));
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(color, alpha), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static size_t PremultiplySse2(unsigned char* pixels, size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i* p = (__m128i*)(pixels + i * 4);
+		__m128i v = _mm_loadu_si128(p);
+		__m128i low = PremultiplyHalf(_mm_unpacklo_epi8(v, zero));
+		__m128i high = PremultiplyHalf(_mm_unpackhi_epi8(v, zero));
+		_mm_storeu_si128(p, _mm_packus_epi16(low, high));
+	}
+	return i;
+}
+#endif
+
+void PixelKernels::ExpandRgbToRgba(const unsigned char* src, unsigned char* dst, size_t pixels)
+{
+	size_t done = 0;
+#ifdef CPU_X86
+	static const bool ssse3 = CpuFeatures::HasSsse3();
+	if (ssse3)
+		done = ExpandSsse3(src, dst, pixels);
+#endif
+	ExpandScalar(src + done * 3, dst + done * 4, pixels - done);
+}
+
+void PixelKernels::SwapRedBlue(unsigned char* pixels, size_t count)
+{
+	size_t done = 0;
+#ifdef CPU_X86
+	static const bool avx2 = CpuFeatures::HasAvx2();
+	static const bool ssse3 = CpuFeatures::HasSsse3();
+	if (avx2)
+		done = SwapAvx2(pixels, count);
+	else if (ssse3)
+		done = SwapSsse3(pixels, count);
+#endif
+	SwapScalar(pixels + done * 4, count - done);
+}
+
+void PixelKernels::PremultiplyAlpha(unsigned char* pixels, size_t count)
+{
+	size_t done = 0;
+#ifdef CPU_X86
+	done = PremultiplySse2(pixels, count);
+#endif
+	PremultiplyScalar(pixels + done * 4, count - done);
+}
+
+void PixelKernels::FlipRows(unsigned char* pixels, size_t rowBytes, size_t rows)
+{
+	for (size_t top = 0, bottom = rows - 1; rows > 0 && top < bottom; top++, bottom--)
+	{
+		unsigned char* a = pixels + top * rowBytes;
+		unsigned char* b = pixels + bottom * rowBytes;
+		size_t i = 0;
+#ifdef CPU_X86
+		for (; i + 16 <= rowBytes; i += 16)
+		{
+			__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+			__m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+			_mm_storeu_si128((__m128i*)(a + i), vb);
+			_mm_storeu_si128((__m128i*)(b + i), va);
+		}
+#endif
+		for (; i < rowBytes; i++)
+			std::swap(a[i], b[i]);
+	}
+}
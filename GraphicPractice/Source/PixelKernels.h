@@ -0,0 +1,22 @@
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include <cstddef>
+
+// Byte pixel conversions done before upload so the driver gets data in the
+// layout it copies as is. SSSE3/AVX2 versions are picked at runtime, SSE2
+// is the baseline on x86 and other CPUs use plain loops.
+class PixelKernels
+{
+public:
+	// RGB -> RGBA with opaque alpha, src and dst must not overlap
+	static void ExpandRgbToRgba(const unsigned char* src, unsigned char* dst, size_t pixels);
+	// RGBA <-> BGRA in place
+	static void SwapRedBlue(unsigned char* pixels, size_t count);
+	// color *= alpha for 4 channel pixels (either order, alpha last), rounded like (c * a + 127) / 255
+	static void PremultiplyAlpha(unsigned char* pixels, size_t count);
+	// upside down in place
+	static void FlipRows(unsigned char* pixels, size_t rowBytes, size_t rows);
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "PngKernels.h"
+#include "CpuFeatures.h"
+
+#include <cstring>
+
+enum PngFilter
+{
+	FilterNone = 0,
+	FilterSub = 1,
+	FilterUp = 2,
+	FilterAvg = 3,
+	FilterPaeth = 4,
+	FilterAvgFirst = 5,
+	FilterPaethFirst = 6
+};
+
+#ifdef CPU_X86
+// one pixel in the low bytes of a register, RGB pixels are read and written
+// as exactly 3 bytes so nothing past the row is touched. They go through
+// registers as 2 + 1 bytes, a 3 byte memcpy into an int takes a trip through
+// the stack that stalls the avg/paeth dependency chain.
+template <int PixelBytes>
+static __m128i LoadPixel(const unsigned char* p)
+{
+	int value;
+	if constexpr (PixelBytes == 4)
+		memcpy(&value, p, 4);
+	else
+	{
+		unsigned short low;
+		memcpy(&low, p, 2);
+		value = low | (p[2] << 16);
+	}
+	return _mm_cvtsi32_si128(value);
+}
+
+template <int PixelBytes>
+static void StorePixel(unsigned char* p, __m128i pixel)
+{
+	int value = _mm_cvtsi128_si32(pixel);
+	if constexpr (PixelBytes == 4)
+		memcpy(p, &value, 4);
+	else
+	{
+		unsigned short low = (unsigned short)value;
+		memcpy(p, &low, 2);
+		p[2] = (unsigned char)(value >> 16);
+	}
+}
+
+static void UnfilterUp(unsigned char* cur, const unsigned char* prior, const unsigned char* raw, int count)
+{
+	int k = 0;
+	for (; k + 16 <= count; k += 16)
+	{
+		__m128i sum = _mm_add_epi8(_mm_loadu_si128((const __m128i*)(raw + k)), _mm_loadu_si128((const __m128i*)(prior + k)));
+		_mm_storeu_si128((__m128i*)(cur + k), sum);
+	}
+	for (; k < count; k++)
+		cur[k] = (unsigned char)(raw[k] + prior[k]);
+}
+
+// 4 pixels per step: a prefix sum inside the register plus the last pixel before it
+static int UnfilterSub4(unsigned char* cur, const unsigned char* raw, int count)
+{
+	__m128i last = _mm_shuffle_epi32(LoadPixel<4>(cur - 4), 0);
+	int k = 0;
+	for (; k + 16 <= count; k += 16)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(raw + k));
+		x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+		x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi8(x, last);
+		_mm_storeu_si128((__m128i*)(cur + k), x);
+		last = _mm_shuffle_epi32(x, 0xff);
+	}
+	return k;
+}
+
+// the same with 4 RGB pixels per step; the 16 byte store spills 4 bytes the next step overwrites
+CPU_TARGET_SSSE3 static int UnfilterSub3(unsigned char* cur, const unsigned char* raw, int count)
+{
+	const __m128i spread = _mm_setr_epi8(0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, -1, -1, -1, -1);
+	const __m128i lastPixel = _mm_setr_epi8(9, 10, 11, 9, 10, 11, 9, 10, 11, 9, 10, 11, -1, -1, -1, -1);
+	__m128i last = _mm_shuffle_epi8(LoadPixel<3>(cur - 3), spread);
+	int k = 0;
+	for (; k + 16 <= count; k += 12)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(raw + k));
+		x = _mm_add_epi8(x, _mm_slli_si128(x, 3));
+		x = _mm_add_epi8(x, _mm_slli_si128(x, 6));
+		x = _mm_add_epi8(x, last);
+		_mm_storeu_si128((__m128i*)(cur + k), x);
+		last = _mm_shuffle_epi8(x, lastPixel);
+	}
+	return k;
+}
+
+// avg and paeth depend on the pixel just written, so they go one pixel at a
+// time with all channels in one register
+template <int PixelBytes>
+static void UnfilterAvg(unsigned char* cur, const unsigned char* prior, const unsigned char* raw, int count)
+{
+	const __m128i one = _mm_set1_epi8(1);
+	__m128i left = LoadPixel<PixelBytes>(cur - PixelBytes);
+	for (int k = 0; k < count; k += PixelBytes)
+	{
+		__m128i up = LoadPixel<PixelBytes>(prior + k);
+		// avg_epu8 rounds up, the filter rounds down
+		__m128i average = _mm_sub_epi8(_mm_avg_epu8(left, up), _mm_and_si128(_mm_xor_si128(left, up), one));
+		left = _mm_add_epi8(LoadPixel<PixelBytes>(raw + k), average);
+		StorePixel<PixelBytes>(cur + k, left);
+	}
+}
+
+static __m128i Abs16(__m128i x)
+{
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static __m128i Select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+template <int PixelBytes>
+static void UnfilterPaeth(unsigned char* cur, const unsigned char* prior, const unsigned char* raw, int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i left = _mm_unpacklo_epi8(LoadPixel<PixelBytes>(cur - PixelBytes), zero);
+	__m128i upLeft = _mm_unpacklo_epi8(LoadPixel<PixelBytes>(prior - PixelBytes), zero);
+	for (int k = 0; k < count; k += PixelBytes)
+	{
+		__m128i up = _mm_unpacklo_epi8(LoadPixel<PixelBytes>(prior + k), zero);
+		// distances of left + up - upLeft to left, up and upLeft, ties go left, then up
+		__m128i upDelta = _mm_sub_epi16(up, upLeft);
+		__m128i leftDelta = _mm_sub_epi16(left, upLeft);
+		__m128i pa = Abs16(upDelta);
+		__m128i pb = Abs16(leftDelta);
+		__m128i pc = Abs16(_mm_add_epi16(upDelta, leftDelta));
+		__m128i smallest = _mm_min_epi16(_mm_min_epi16(pa, pb), pc);
+		__m128i predictor = Select(_mm_cmpeq_epi16(pb, smallest), up, upLeft);
+		predictor = Select(_mm_cmpeq_epi16(pa, smallest), left, predictor);
+		__m128i pixel = _mm_add_epi8(LoadPixel<PixelBytes>(raw + k), _mm_packus_epi16(predictor, predictor));
+		StorePixel<PixelBytes>(cur + k, pixel);
+		left = _mm_unpacklo_epi8(pixel, zero);
+		upLeft = up;
+	}
+}
+#endif
+
+bool PngKernels::Unfilter(int filter, unsigned char* cur, const unsigned char* prior, const unsigned char* raw, int count, int pixelBytes)
+{
+#ifdef CPU_X86
+	if (filter == FilterUp)
+	{
+		UnfilterUp(cur, prior, raw, count);
+		return true;
+	}
+	if (pixelBytes != 3 && pixelBytes != 4)
+		return false;
+	switch (filter)
+	{
+	case FilterSub:
+	// on the first row paeth always predicts the left pixel
+	case FilterPaethFirst:
+	{
+		int k = 0;
+		if (pixelBytes == 4)
+			k = UnfilterSub4(cur, raw, count);
+		else if (CpuFeatures::HasSsse3())
+			k = UnfilterSub3(cur, raw, count);
+		for (; k < count; k++)
+			cur[k] = (unsigned char)(raw[k] + cur[k - pixelBytes]);
+		return true;
+	}
+	case FilterAvg:
+		if (pixelBytes == 4)
+			UnfilterAvg<4>(cur, prior, raw, count);
+		else
+			UnfilterAvg<3>(cur, prior, raw, count);
+		return true;
+	case FilterPaeth:
+		if (pixelBytes == 4)
+			UnfilterPaeth<4>(cur, prior, raw, count);
+		else
+			UnfilterPaeth<3>(cur, prior, raw, count);
+		return true;
+	default:
+		return false;
+	}
+#else
+	(void)filter;
+	(void)cur;
+	(void)prior;
+	(void)raw;
+	(void)count;
+	(void)pixelBytes;
+	return false;
+#endif
+}
@@ -0,0 +1,23 @@
+#ifndef PNG_KERNELS_H
+#define PNG_KERNELS_H
+
+// 0 builds stb_image.cpp with the stock PNG decoder, to benchmark against
+#ifndef PNG_FAST_DECODE
+#define PNG_FAST_DECODE 1
+#endif
+
+// SSE2/SSSE3 PNG row defilters for stb_image's 8 and 16 bit path. Rows are
+// unfiltered as bytes, so only the pixel size matters: up works for any size,
+// sub/avg/paeth for 3 and 4 byte pixels (RGB/RGBA, gray+alpha at 16 bit), the
+// rest stays on stb_image's loops. stb_image.cpp hands them in through STBI_PNG_UNFILTER_HOOK and
+// turns on stb_image's inflate fast path (STBI_FAST_INFLATE) with them.
+class PngKernels
+{
+public:
+	// stb_image's filter numbers: 0 none .. 4 paeth, 5 and 6 the first row's avg and paeth.
+	// cur, prior and raw point past the row's first pixel, count bytes are left.
+	// false leaves the row to stb_image.
+	static bool Unfilter(int filter, unsigned char* cur, const unsigned char* prior, const unsigned char* raw, int count, int pixelBytes);
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "ProgramCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+
+std::string ProgramCache::directory = "ShaderCache";
+uint64_t ProgramCache::sizeLimit = 64ull * 1024 * 1024;
+
+// file layout: magic, binary format, binary length, binary
+static const char cacheMagic[4] = { 'G', 'P', 'B', '1' };
+
+// bytes in the directory as of the last sweep plus everything stored since,
+// the directory is only scanned again once this passes the size limit
+static std::mutex sweepMutex;
+static uint64_t storedBytes = 0;
+static bool storedBytesKnown = false;
+
+// 64 bit FNV-1a
+static void HashBytes(uint64_t& hash, const char* data, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+static void HashString(uint64_t& hash, const char* str)
+{
+	// unknown strings still separate fields
+	if (str)
+		HashBytes(hash, str, strlen(str));
+	HashBytes(hash, "\0", 1);
+}
+
+// a temporary file of its own for every store: the warmup thread and the render thread
+// can store the same key at once, and so can two processes sharing the directory
+static std::string TempPathFor(const std::string& path)
+{
+	static const unsigned int processTag = std::random_device()();
+	static std::atomic<unsigned int> counter(0);
+	return path + "." + std::to_string(processTag) + "." + std::to_string(counter++) + ".tmp";
+}
+
+void ProgramCache::SetDirectory(const std::string& path)
+{
+	directory = path;
+	std::lock_guard<std::mutex> lock(sweepMutex);
+	storedBytesKnown = false;
+}
+
+void ProgramCache::SetSizeLimit(uint64_t bytes)
+{
+	sizeLimit = bytes;
+}
+
+std::string ProgramCache::PathFor(const std::string& key)
+{
+	return directory + "/" + key + ".bin";
+}
+
+bool ProgramCache::IsSupported()
+{
+	// glad only loads glProgramBinary and glGetProgramBinary on 4.1 contexts, a 3.3
+	// context may still report formats through ARB_get_program_binary
+	if (!GLAD_GL_VERSION_4_1)
+		return false;
+	int formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+std::string ProgramCache::MakeKey(const std::vector<std::string_view>& sources)
+{
+	uint64_t hash = 14695981039346656037ull;
+	// binaries are only valid for the driver that produced them
+	HashString(hash, (const char*)glGetString(GL_VENDOR));
+	HashString(hash, (const char*)glGetString(GL_RENDERER));
+	HashString(hash, (const char*)glGetString(GL_VERSION));
+	for (std::string_view source : sources)
+	{
+		HashBytes(hash, source.data(), source.size());
+		HashBytes(hash, "\0", 1);
+	}
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+	return key;
+}
+
+unsigned int ProgramCache::Load(const std::string& key)
+{
+	if (!IsSupported())
+		return 0;
+	std::ifstream file(PathFor(key), std::ios::binary);
+	if (!file)
+		return 0;
+	char magic[4];
+	uint32_t format = 0, length = 0;
+	file.read(magic, sizeof(magic));
+	file.read((char*)&format, sizeof(format));
+	file.read((char*)&length, sizeof(length));
+	if (!file || memcmp(magic, cacheMagic, sizeof(magic)) != 0 || length == 0)
+		return 0;
+	std::vector<char> binary(length);
+	if (!file.read(binary.data(), length))
+		return 0;
+
+	unsigned int program = glCreateProgram();
+	glProgramBinary(program, format, binary.data(), length);
+	// driver updates or a different GPU make the binary invalid
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+	// the write time doubles as the last use for eviction
+	std::error_code error;
+	std::filesystem::last_write_time(PathFor(key), std::filesystem::file_time_type::clock::now(), error);
+	return program;
+}
+
+bool ProgramCache::Store(const std::string& key, unsigned int program)
+{
+	if (!IsSupported())
+		return false;
+	int length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return false;
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	// write to a temporary file first so a crash never leaves half a binary behind
+	std::string path = PathFor(key);
+	std::string tempPath = TempPathFor(path);
+	bool written;
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::PROGRAM_CACHE::CANNOT_WRITE " << tempPath << std::endl;
+			return false;
+		}
+		uint32_t format32 = format, length32 = length;
+		file.write(cacheMagic, sizeof(cacheMagic));
+		file.write((const char*)&format32, sizeof(format32));
+		file.write((const char*)&length32, sizeof(length32));
+		file.write(binary.data(), length);
+		written = (bool)file;
+	}
+	// a short write (disk full) leaves nothing behind either
+	if (written)
+		std::filesystem::rename(tempPath, path, error);
+	if (!written || error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	bool sweep;
+	{
+		std::lock_guard<std::mutex> lock(sweepMutex);
+		storedBytes += sizeof(cacheMagic) + 2 * sizeof(uint32_t) + length;
+		sweep = !storedBytesKnown || storedBytes > sizeLimit;
+	}
+	if (sweep)
+		Evict();
+	return true;
+}
+
+void ProgramCache::Evict()
+{
+	struct CacheFile
+	{
+		std::filesystem::path path;
+		uint64_t size;
+		std::filesystem::file_time_type lastUse;
+	};
+	std::lock_guard<std::mutex> lock(sweepMutex);
+
+	std::error_code error;
+	std::vector<CacheFile> files;
+	uint64_t total = 0;
+	for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+	{
+		if (it->path().extension() != ".bin")
+			continue;
+		CacheFile file;
+		file.path = it->path();
+		file.size = it->file_size(error);
+		file.lastUse = it->last_write_time(error);
+		if (error)
+		{
+			error.clear();
+			continue;
+		}
+		total += file.size;
+		files.push_back(file);
+	}
+	if (total > sizeLimit)
+	{
+		std::sort(files.begin(), files.end(),
+			[](const CacheFile& a, const CacheFile& b) { return a.lastUse < b.lastUse; });
+		for (const CacheFile& file : files)
+		{
+			if (total <= sizeLimit)
+				break;
+			if (std::filesystem::remove(file.path, error))
+				total -= file.size;
+		}
+	}
+	storedBytes = total;
+	storedBytesKnown = true;
+}
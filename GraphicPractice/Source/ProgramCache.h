@@ -0,0 +1,36 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Stores linked program binaries on disk so warm starts skip compile and link
+class ProgramCache
+{
+private:
+	static std::string directory;
+	static uint64_t sizeLimit;
+	// path of the cache file for a key
+	static std::string PathFor(const std::string& key);
+	// removes least recently used files until the directory fits the size limit
+	static void Evict();
+public:
+	// directory for cache files, created on first store
+	static void SetDirectory(const std::string& path);
+	// total bytes the directory may grow to, every variant gets its own binary
+	static void SetSizeLimit(uint64_t bytes);
+	// false before GL 4.1 or when the driver exposes no binary formats
+	static bool IsSupported();
+	// key from the sources plus GL_VENDOR/GL_RENDERER/GL_VERSION
+	static std::string MakeKey(const std::vector<std::string_view>& sources);
+	// creates a program from the cached binary, returns 0 if missing or rejected
+	static unsigned int Load(const std::string& key);
+	// writes the binary of a linked program
+	static bool Store(const std::string& key, unsigned int program);
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "ProgramPipelineCache.h"
+
+int ProgramPipelineCache::StageIndex(GLenum type)
+{
+	switch (type)
+	{
+	case GL_VERTEX_SHADER: return 0;
+	case GL_TESS_CONTROL_SHADER: return 1;
+	case GL_TESS_EVALUATION_SHADER: return 2;
+	case GL_GEOMETRY_SHADER: return 3;
+	case GL_FRAGMENT_SHADER: return 4;
+	}
+	return -1;
+}
+
+GLbitfield ProgramPipelineCache::StageBit(int index)
+{
+	static const GLbitfield bits[stageCount] = {
+		GL_VERTEX_SHADER_BIT, GL_TESS_CONTROL_SHADER_BIT, GL_TESS_EVALUATION_SHADER_BIT,
+		GL_GEOMETRY_SHADER_BIT, GL_FRAGMENT_SHADER_BIT
+	};
+	return bits[index];
+}
+
+Shader& ProgramPipelineCache::GetStage(GLenum type, const std::string& path, const std::vector<std::string>& defines)
+{
+	std::string key = std::to_string(type) + "|" + ShaderPreprocessor::NormalizePath(path);
+	for (const std::string& define : defines)
+		key += "|" + define;
+	auto it = stagePrograms.find(key);
+	if (it != stagePrograms.end())
+		return *it->second;
+
+	// failed stages are kept too (program 0) so they are not rebuilt every frame
+	std::unique_ptr<Shader>& shader = stagePrograms[key];
+	if (StageIndex(type) == -1)
+	{
+		std::cout << "ERROR::PROGRAM_PIPELINE::UNSUPPORTED_STAGE " << ShaderCompiler::StageName(type) << std::endl;
+		shader.reset(new Shader(0u));
+	}
+	else
+		shader.reset(new Shader(type, path.c_str(), defines));
+	return *shader;
+}
+
+void ProgramPipelineCache::SetupStages(Pipeline& pipeline, const StageSet& stages)
+{
+	for (int i = 0; i < stageCount; i++)
+	{
+		unsigned int program = stages[i] ? stages[i]->GetID() : 0;
+		glUseProgramStages(pipeline.id, StageBit(i), program);
+		pipeline.revisions[i] = stages[i] ? stages[i]->GetRevision() : 0;
+	}
+}
+
+void ProgramPipelineCache::Bind(Shader* vertex, Shader* fragment, Shader* geometry,
+	Shader* tessControl, Shader* tessEvaluation)
+{
+	StageSet stages = { vertex, tessControl, tessEvaluation, geometry, fragment };
+	auto it = pipelines.find(stages);
+	if (it == pipelines.end())
+	{
+		Pipeline pipeline;
+		glGenProgramPipelines(1, &pipeline.id);
+		SetupStages(pipeline, stages);
+		it = pipelines.emplace(stages, pipeline).first;
+	}
+	else
+	{
+		// a stage program was swapped by a reload since the pipeline was set up
+		for (int i = 0; i < stageCount; i++)
+		{
+			if (stages[i] && stages[i]->GetRevision() != it->second.revisions[i])
+			{
+				SetupStages(it->second, stages);
+				break;
+			}
+		}
+	}
+	// a program bound with glUseProgram would override the pipeline
+	glUseProgram(0);
+	glBindProgramPipeline(it->second.id);
+	boundPipeline = it->second.id;
+}
+
+void ProgramPipelineCache::SetActiveStage(const Shader& stage)
+{
+	glActiveShaderProgram(boundPipeline, stage.GetID());
+}
+
+ProgramPipelineCache::~ProgramPipelineCache()
+{
+	for (auto& pipeline : pipelines)
+		glDeleteProgramPipelines(1, &pipeline.second.id);
+}
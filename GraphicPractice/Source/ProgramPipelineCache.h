@@ -0,0 +1,55 @@
+#ifndef PROGRAM_PIPELINE_CACHE_H
+#define PROGRAM_PIPELINE_CACHE_H
+
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+
+#include <array>
+#include <map>
+#include <memory>
+
+// Separable programs (GL 4.1 / ARB_separate_shader_objects): every stage is
+// compiled and linked once on its own and stages are combined at bind time
+// through program pipeline objects, so N vertex x M fragment variants cost
+// N + M links instead of N * M.
+class ProgramPipelineCache
+{
+private:
+	// vertex, tess control, tess evaluation, geometry, fragment
+	static const int stageCount = 5;
+	typedef std::array<Shader*, stageCount> StageSet;
+	struct Pipeline
+	{
+		unsigned int id = 0;
+		// program revisions the pipeline was set up with, ShaderWatcher reloads change them
+		std::array<unsigned int, stageCount> revisions = {};
+	};
+
+	// (stage, path, defines) -> separable program
+	std::map<std::string, std::unique_ptr<Shader>> stagePrograms;
+	std::map<StageSet, Pipeline> pipelines;
+	unsigned int boundPipeline = 0;
+
+	static int StageIndex(GLenum type);
+	static GLbitfield StageBit(int index);
+	void SetupStages(Pipeline& pipeline, const StageSet& stages);
+public:
+	ProgramPipelineCache() = default;
+	ProgramPipelineCache(const ProgramPipelineCache&) = delete;
+	ProgramPipelineCache& operator=(const ProgramPipelineCache&) = delete;
+	~ProgramPipelineCache();
+
+	// separable program for one stage of a file, compiled on first use; it keeps its
+	// path and defines, so ShaderWatcher can reload it
+	Shader& GetStage(GLenum type, const std::string& path, const std::vector<std::string>& defines = {});
+	// binds the pipeline made of the given stage programs (nullptr for unused stages),
+	// created on first use
+	void Bind(Shader* vertex, Shader* fragment, Shader* geometry = nullptr,
+		Shader* tessControl = nullptr, Shader* tessEvaluation = nullptr);
+	// makes glUniform* calls (and Shader::Flush) target this stage of the bound pipeline
+	void SetActiveStage(const Shader& stage);
+	size_t PipelineCount() const { return pipelines.size(); }
+	size_t StageProgramCount() const { return stagePrograms.size(); }
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef REFLECTED_UNIFORM_H
+#define REFLECTED_UNIFORM_H
+
+#include "Shader.h"
+
+#include <type_traits>
+
+// Typed member of a uniform struct generated by Tools/ShaderReflect.
+// The name hash is a compile time constant; Bind resolves the slot once
+// and Set is a direct store into the shader's uniform shadow store.
+template <typename T, uint32_t NameHash>
+struct ReflectedUniform
+{
+	static_assert(std::is_same<T, bool>::value || std::is_same<T, int>::value || std::is_same<T, float>::value,
+		"Shader only has bool, int and float setters");
+	static constexpr uint32_t nameHash = NameHash;
+	UniformHandle handle;
+
+	// false if the program no longer has the uniform (e.g. optimized out)
+	bool Bind(const Shader& shader)
+	{
+		handle = shader.GetUniform(NameHash);
+		return handle.IsValid();
+	}
+	void Set(const Shader& shader, T value) const
+	{
+		if constexpr (std::is_same<T, bool>::value)
+			shader.setBool(handle, value);
+		else if constexpr (std::is_same<T, int>::value)
+			shader.setInt(handle, value);
+		else
+			shader.setFloat(handle, value);
+	}
+};
+
+#endif
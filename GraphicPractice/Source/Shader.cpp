@@ -1,82 +1,142 @@
 #include "Shader.h"
+#include "ProgramCache.h"
+#include "ShaderFile.h"
+#include "ShaderPreprocessor.h"
+
+#include <cstring>
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
+	: vertexPath(vertexPath), fragmentPath(fragmentPath)
 {
-	// 1. retrive the vertex/fragment source code from filePath
-	std::string vertexCode;
-	std::string fragmentCode;
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
-	// ensure ifstream objects can throw exceptions
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	try
-	{
-		// open files
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		std::stringstream vShaderStream, fShaderStream;
-		// read file's buffer contents into streams
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
-		// close file handlers
-		vShaderFile.close();
-		fShaderFile.close();
-		// convert stream into string
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
-	}
-	catch (std::ifstream::failure e)
-	{
-		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
-	}
-	const char* vShaderCode = vertexCode.c_str();
-	const char* fShaderCode = fragmentCode.c_str();
-	// 2. compile shaders
-	unsigned int vertex, fragment;
-	int success;
-	char infoLog[512];
-	
-	// vertex Shader
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
-	// print compile errors if any
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
+	// 1. retrive the vertex/fragment source code from filePath, resolving includes
+	ShaderPreprocessor preprocessor;
+	PreprocessedShader vertex = preprocessor.Process(vertexPath);
+	PreprocessedShader fragment = preprocessor.Process(fragmentPath);
+	dependencies = vertex.files;
+	dependencies.insert(dependencies.end(), fragment.files.begin(), fragment.files.end());
 
-	// vertex Shader
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
-	// print compile errors if any
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-	if (!success)
+	// 2. compile or load from the program cache
+	ID = BuildProgram(vertex.code, fragment.code);
+
+	// remember where every uniform lives
+	CacheUniforms();
+}
+
+Shader::Shader(const char* shaderPath)
+	: vertexPath(shaderPath)
+{
+	// multi-stage file, compiled straight from the mapping
+	ShaderFile file;
+	if (file.Open(shaderPath))
+		ID = BuildProgram(file.GetStages());
+	else
+		ID = 0;
+	dependencies.push_back(ShaderPreprocessor::NormalizePath(shaderPath));
+
+	// remember where every uniform lives
+	CacheUniforms();
+}
+
+Shader::Shader(GLenum stageType, const char* path, const std::vector<std::string>& defines)
+	: vertexPath(path), stageType(stageType), defines(defines)
+{
+	ShaderPreprocessor preprocessor;
+	PreprocessedShader source = preprocessor.Process(path, defines);
+	dependencies = source.files;
+	ID = source.success ? BuildProgram({ { stageType, source.code } }, true) : 0;
+
+	// remember where every uniform lives
+	CacheUniforms();
+}
+
+unsigned int Shader::BuildProgram(std::string_view vertexCode, std::string_view fragmentCode)
+{
+	return BuildProgram({ { GL_VERTEX_SHADER, vertexCode }, { GL_FRAGMENT_SHADER, fragmentCode } });
+}
+
+unsigned int Shader::BuildProgram(const std::vector<ShaderStageSource>& stages, bool separable)
+{
+	// try the binary from a previous run, contexts without binaries skip the cache
+	std::string cacheKey;
+	if (ProgramCache::IsSupported())
 	{
-		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+		std::vector<std::string_view> sources;
+		for (const ShaderStageSource& stage : stages)
+			sources.push_back(stage.source);
+		// a separable program links differently from the monolithic one
+		if (separable)
+			sources.push_back("#separable");
+		cacheKey = ProgramCache::MakeKey(sources);
+		unsigned int program = ProgramCache::Load(cacheKey);
+		if (program != 0)
+			return program;
 	}
 
-	// shader program
-	ID = glCreateProgram();
-	glAttachShader(ID, vertex);
-	glAttachShader(ID, fragment);
-	glLinkProgram(ID);
-	// print linking errors if any
-	glGetProgramiv(ID, GL_LINK_STATUS, &success);
-	if (!success)
+	// compile and link, all stages are submitted before any status query
+	ShaderCompiler compiler;
+	size_t index = compiler.Add(stages, separable);
+	compiler.Finish();
+	unsigned int program = compiler.Release(index);
+	if (program != 0 && !cacheKey.empty())
+		ProgramCache::Store(cacheKey, program);
+	return program;
+}
+
+void Shader::CacheUniforms()
+{
+	uniformSlots.clear();
+	uniformHashes.clear();
+	uniforms.clear();
+	dirtySlots.clear();
+	int count = 0, maxLength = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	if (count <= 0 || maxLength <= 0)
+		return;
+	std::string name(maxLength, '\0');
+	for (int i = 0; i < count; i++)
 	{
-		glGetProgramInfoLog(ID, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+		int length = 0, size = 0;
+		GLenum type;
+		glGetActiveUniform(ID, i, maxLength, &length, &size, &type, &name[0]);
+		std::string uniformName = name.substr(0, length);
+		int location = glGetUniformLocation(ID, uniformName.c_str());
+		// uniforms inside blocks have no location
+		if (location == -1)
+			continue;
+		UniformSlot slot;
+		slot.name = uniformName;
+		slot.location = location;
+		slot.type = type;
+		uniforms.push_back(slot);
+		int index = (int)uniforms.size() - 1;
+		uniformSlots[uniformName] = index;
+		uniformHashes[UniformNameHash(uniformName)] = index;
+		// arrays are reported as "name[0]", also allow plain "name"
+		if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+		{
+			std::string baseName = uniformName.substr(0, uniformName.size() - 3);
+			uniformSlots[baseName] = index;
+			uniformHashes[UniformNameHash(baseName)] = index;
+		}
 	}
+}
+
+Shader::Shader(unsigned int programID)
+	: ID(programID)
+{
+	CacheUniforms();
+}
 
-	// delete the shaders as they are linked into our program now and no longer necessary
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
+void Shader::SwapProgram(unsigned int programID)
+{
+	// the old program stays valid until the new one is in place
+	unsigned int oldID = ID;
+	ID = programID;
+	CacheUniforms();
+	revision++;
+	if (oldID != 0)
+		glDeleteProgram(oldID);
 }
 
 Shader::~Shader()
@@ -84,11 +144,41 @@ Shader::~Shader()
 	glDeleteProgram(ID);
 }
 
-unsigned int Shader::GetID()
+unsigned int Shader::GetID() const
 {
 	return ID;
 }
 
+unsigned int Shader::GetRevision() const
+{
+	return revision;
+}
+
+const std::string& Shader::GetVertexPath() const
+{
+	return vertexPath;
+}
+
+const std::string& Shader::GetFragmentPath() const
+{
+	return fragmentPath;
+}
+
+GLenum Shader::GetStageType() const
+{
+	return stageType;
+}
+
+const std::vector<std::string>& Shader::GetDefines() const
+{
+	return defines;
+}
+
+const std::vector<std::string>& Shader::GetDependencies() const
+{
+	return dependencies;
+}
+
 void Shader::use()
 {
 	glUseProgram(ID);
@@ -96,15 +186,133 @@ void Shader::use()
 
 void Shader::setBool(const std::string& name, bool value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	StageUniform(GetUniformSlot(name), GL_INT, value ? 1 : 0);
 }
 
 void Shader::setInt(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	StageUniform(GetUniformSlot(name), GL_INT, (uint32_t)value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const
 {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	StageUniform(GetUniformSlot(name), GL_FLOAT, bits);
+}
+
+int Shader::GetUniformSlot(const std::string& name) const
+{
+	auto it = uniformSlots.find(name);
+	return it != uniformSlots.end() ? it->second : -1;
+}
+
+int Shader::GetUniformLocation(const std::string& name) const
+{
+	// -1 is silently ignored by glUniform*, same as the driver would do
+	int slot = GetUniformSlot(name);
+	return slot != -1 ? uniforms[slot].location : -1;
+}
+
+UniformHandle Shader::GetUniform(const std::string& name) const
+{
+	UniformHandle handle;
+	handle.slot = GetUniformSlot(name);
+	handle.location = handle.slot != -1 ? uniforms[handle.slot].location : -1;
+	return handle;
+}
+
+UniformHandle Shader::GetUniform(uint32_t nameHash) const
+{
+	UniformHandle handle;
+	auto it = uniformHashes.find(nameHash);
+	if (it != uniformHashes.end())
+	{
+		handle.slot = it->second;
+		handle.location = uniforms[handle.slot].location;
+	}
+	return handle;
+}
+
+void Shader::setBool(UniformHandle handle, bool value) const
+{
+	StageUniform(handle.slot, GL_INT, value ? 1 : 0);
+}
+
+void Shader::setInt(UniformHandle handle, int value) const
+{
+	StageUniform(handle.slot, GL_INT, (uint32_t)value);
+}
+
+void Shader::setFloat(UniformHandle handle, float value) const
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	StageUniform(handle.slot, GL_FLOAT, bits);
+}
+
+void Shader::StageUniform(int slot, GLenum kind, uint32_t bits) const
+{
+	// unknown uniform, or a handle from before a reload
+	if (slot < 0 || slot >= (int)uniforms.size())
+		return;
+	UniformSlot& uniform = uniforms[slot];
+	if (uniform.kind == kind && uniform.bits == bits)
+	{
+		uniformStats.skipped++;
+		return;
+	}
+	uniform.kind = kind;
+	uniform.bits = bits;
+	uniform.changes++;
+	if (!uniform.dirty)
+	{
+		uniform.dirty = true;
+		dirtySlots.push_back(slot);
+	}
+}
+
+void Shader::Flush() const
+{
+	for (int slot : dirtySlots)
+	{
+		UniformSlot& uniform = uniforms[slot];
+		if (uniform.kind == GL_FLOAT)
+		{
+			float value;
+			memcpy(&value, &uniform.bits, sizeof(value));
+			glUniform1f(uniform.location, value);
+		}
+		else
+			glUniform1i(uniform.location, (int)uniform.bits);
+		uniform.dirty = false;
+		uniformStats.uploaded++;
+	}
+	dirtySlots.clear();
+}
+
+const UniformStats& Shader::GetUniformStats() const
+{
+	return uniformStats;
+}
+
+const std::vector<Shader::UniformSlot>& Shader::GetUniformSlots() const
+{
+	return uniforms;
+}
+
+void Shader::ResetUniformStats()
+{
+	uniformStats = UniformStats();
+}
+
+void Shader::BindUniformBlock(const std::string& blockName, unsigned int binding) const
+{
+	unsigned int index = glGetUniformBlockIndex(ID, blockName.c_str());
+	if (index == GL_INVALID_INDEX)
+	{
+		std::cout << "ERROR::SHADER::UNIFORM_BLOCK_NOT_FOUND " << blockName << std::endl;
+		return;
+	}
+	glUniformBlockBinding(ID, index, binding);
 }
\ No newline at end of file
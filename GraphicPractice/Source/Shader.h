@@ -3,28 +3,135 @@
 
 #include <glad/glad.h>
 
+#include "ShaderCompiler.h"
+
+#include <cstdint>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// uniform location resolved once, so per-frame updates skip the name lookup
+struct UniformHandle
+{
+	int location = -1;
+	// index into the shader's uniform shadow store
+	int slot = -1;
+	// false if the uniform is not active in the program
+	bool IsValid() const { return location != -1; }
+};
+
+// 32 bit FNV-1a of a uniform name, usable at compile time
+constexpr uint32_t UniformNameHash(std::string_view name)
+{
+	uint32_t hash = 2166136261u;
+	for (char c : name)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// how many uniform updates were dropped as redundant and how many reached the driver
+struct UniformStats
+{
+	unsigned long long skipped = 0;
+	unsigned long long uploaded = 0;
+};
 
 class Shader
 {
+public:
+	// CPU copy of a uniform value, uploaded by Flush when dirty
+	struct UniformSlot
+	{
+		std::string name;
+		int location;
+		// GLSL type from the program, e.g. GL_FLOAT or GL_SAMPLER_2D
+		GLenum type;
+		// GL_INT or GL_FLOAT once a value was set, decides the glUniform call
+		GLenum kind = GL_NONE;
+		uint32_t bits = 0;
+		// how often the value really changed
+		unsigned int changes = 0;
+		bool dirty = false;
+	};
 private:
 	unsigned int ID;
+	// bumped every time the program is replaced
+	unsigned int revision = 0;
+	// source files, empty for adopted programs (vertexPath only for .shader files
+	// and stage programs)
+	std::string vertexPath;
+	std::string fragmentPath;
+	// stage programs: the one stage in vertexPath and its defines, linked separable
+	GLenum stageType = GL_NONE;
+	std::vector<std::string> defines;
+	// every file the sources were built from, includes too
+	std::vector<std::string> dependencies;
+	// active uniforms of the linked program: name -> slot
+	std::unordered_map<std::string, int> uniformSlots;
+	// UniformNameHash(name) -> slot, for lookups by precomputed hash
+	std::unordered_map<uint32_t, int> uniformHashes;
+	mutable std::vector<UniformSlot> uniforms;
+	mutable std::vector<int> dirtySlots;
+	mutable UniformStats uniformStats;
+	// fills uniformSlots from the linked program
+	void CacheUniforms();
+	int GetUniformSlot(const std::string& name) const;
 public:
 	// getter for program id
-	unsigned int GetID();
+	unsigned int GetID() const;
+	// changes after every reload, uniform handles must be resolved again
+	unsigned int GetRevision() const;
+	const std::string& GetVertexPath() const;
+	const std::string& GetFragmentPath() const;
+	// GL_NONE unless this is a separable stage program
+	GLenum GetStageType() const;
+	const std::vector<std::string>& GetDefines() const;
+	const std::vector<std::string>& GetDependencies() const;
+	// compiles and links preprocessed sources (or loads them from the program cache), 0 on failure
+	static unsigned int BuildProgram(std::string_view vertexCode, std::string_view fragmentCode);
+	static unsigned int BuildProgram(const std::vector<ShaderStageSource>& stages, bool separable = false);
 	// constructor
 	Shader(const char* vertexPath, const char* fragmentPath);
+	// multi-stage .shader file with "#shader <stage>" sections
+	explicit Shader(const char* shaderPath);
+	// one stage of a file as a separable program (see ProgramPipelineCache)
+	Shader(GLenum stageType, const char* path, const std::vector<std::string>& defines = {});
+	// takes ownership of an already linked program (e.g. from ShaderCompiler)
+	explicit Shader(unsigned int programID);
 	// destructor
 	~Shader();
+	// replaces the program (hot reload), deletes the old one
+	void SwapProgram(unsigned int programID);
 	// use/activate the shader
 	void use();
-	// utility uniform functions
+	// utility uniform functions, values are staged and sent by Flush
 	void setBool(const std::string& name, bool value) const;
 	void setInt(const std::string& name, int value) const;
 	void setFloat(const std::string& name, float value) const;
+	// uniform handles
+	int GetUniformLocation(const std::string& name) const;
+	UniformHandle GetUniform(const std::string& name) const;
+	// same by UniformNameHash(name), used by generated uniform structs
+	UniformHandle GetUniform(uint32_t nameHash) const;
+	void setBool(UniformHandle handle, bool value) const;
+	void setInt(UniformHandle handle, int value) const;
+	void setFloat(UniformHandle handle, float value) const;
+	// uploads changed uniforms in one pass, call right before drawing with the program bound
+	void Flush() const;
+	const UniformStats& GetUniformStats() const;
+	// shadow store of all active uniforms, indexed by slot
+	const std::vector<UniformSlot>& GetUniformSlots() const;
+	// stores a value, marks it dirty only if it differs from the current one
+	void StageUniform(int slot, GLenum kind, uint32_t bits) const;
+	void ResetUniformStats();
+	// connects a uniform block of the program to a buffer binding point
+	void BindUniformBlock(const std::string& blockName, unsigned int binding) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "ShaderCompiler.h"
+#include "ProgramCache.h"
+
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+bool ShaderCompiler::HasParallelCompile()
+{
+	// static initialization is thread safe, warm-up threads compile too
+	static const bool supported = []()
+	{
+		int count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (int i = 0; i < count; i++)
+		{
+			const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (name && (strcmp(name, "GL_KHR_parallel_shader_compile") == 0 ||
+				strcmp(name, "GL_ARB_parallel_shader_compile") == 0))
+				return true;
+		}
+		return false;
+	}();
+	return supported;
+}
+
+const char* ShaderCompiler::StageName(GLenum type)
+{
+	switch (type)
+	{
+	case GL_VERTEX_SHADER: return "VERTEX";
+	case GL_FRAGMENT_SHADER: return "FRAGMENT";
+	case GL_GEOMETRY_SHADER: return "GEOMETRY";
+	case GL_TESS_CONTROL_SHADER: return "TESS_CONTROL";
+	case GL_TESS_EVALUATION_SHADER: return "TESS_EVALUATION";
+	case GL_COMPUTE_SHADER: return "COMPUTE";
+	}
+	return "UNKNOWN";
+}
+
+size_t ShaderCompiler::Add(std::string_view vertexSource, std::string_view fragmentSource)
+{
+	return Add({ { GL_VERTEX_SHADER, vertexSource }, { GL_FRAGMENT_SHADER, fragmentSource } });
+}
+
+size_t ShaderCompiler::Add(const std::vector<ShaderStageSource>& stages, bool separable)
+{
+	Program program;
+	program.stages = stages;
+	program.separable = separable;
+	programs.push_back(program);
+	return programs.size() - 1;
+}
+
+void ShaderCompiler::Submit()
+{
+	if (submitted)
+		return;
+	submitted = true;
+	// 1. hand every stage to the driver without waiting
+	for (Program& program : programs)
+	{
+		// separable programs are GL 4.1, fail them before creating anything
+		if (program.separable && !GLAD_GL_VERSION_4_1)
+		{
+			std::cout << "ERROR::SHADER_COMPILER::SEPARABLE_NEEDS_GL_4_1" << std::endl;
+			program.done = true;
+			continue;
+		}
+		for (const ShaderStageSource& stage : program.stages)
+		{
+			unsigned int shader = glCreateShader(stage.type);
+			// pointer and length, the source does not need a terminating zero
+			const char* code = stage.source.data();
+			int length = (int)stage.source.size();
+			glShaderSource(shader, 1, &code, &length);
+			glCompileShader(shader);
+			program.shaders.push_back(shader);
+		}
+	}
+	// 2. link, a failed compile just makes the link fail later
+	bool retrievable = ProgramCache::IsSupported();
+	for (Program& program : programs)
+	{
+		if (program.done)
+			continue;
+		program.id = glCreateProgram();
+		for (unsigned int shader : program.shaders)
+			glAttachShader(program.id, shader);
+		// let the driver keep the binary around for the program cache
+		if (retrievable)
+			glProgramParameteri(program.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		if (program.separable)
+			glProgramParameteri(program.id, GL_PROGRAM_SEPARABLE, GL_TRUE);
+		glLinkProgram(program.id);
+	}
+}
+
+bool ShaderCompiler::Poll()
+{
+	Submit();
+	bool parallel = HasParallelCompile();
+	bool allDone = true;
+	for (Program& program : programs)
+	{
+		if (program.done)
+			continue;
+		if (parallel)
+		{
+			int complete = GL_FALSE;
+			glGetProgramiv(program.id, GL_COMPLETION_STATUS_KHR, &complete);
+			if (!complete)
+			{
+				allDone = false;
+				continue;
+			}
+		}
+		// without the extension the status query below simply blocks
+		Collect(program);
+	}
+	return allDone;
+}
+
+void ShaderCompiler::Finish()
+{
+	while (!Poll())
+		std::this_thread::yield();
+}
+
+void ShaderCompiler::Collect(Program& program)
+{
+	program.done = true;
+	int success;
+	glGetProgramiv(program.id, GL_LINK_STATUS, &success);
+	program.success = success != 0;
+	if (!program.success)
+	{
+		// find out which stage broke it
+		for (size_t i = 0; i < program.shaders.size(); i++)
+		{
+			glGetShaderiv(program.shaders[i], GL_COMPILE_STATUS, &success);
+			if (!success)
+			{
+				int length = 0;
+				glGetShaderiv(program.shaders[i], GL_INFO_LOG_LENGTH, &length);
+				std::string infoLog(length > 0 ? length : 1, '\0');
+				glGetShaderInfoLog(program.shaders[i], (int)infoLog.size(), NULL, &infoLog[0]);
+				std::cout << "ERROR::SHADER::" << StageName(program.stages[i].type)
+					<< "::COMPILATION_FAILED\n" << infoLog.c_str() << std::endl;
+			}
+		}
+		int length = 0;
+		glGetProgramiv(program.id, GL_INFO_LOG_LENGTH, &length);
+		std::string infoLog(length > 0 ? length : 1, '\0');
+		glGetProgramInfoLog(program.id, (int)infoLog.size(), NULL, &infoLog[0]);
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog.c_str() << std::endl;
+		glDeleteProgram(program.id);
+		program.id = 0;
+	}
+	// shaders are linked into the program now and no longer necessary
+	for (unsigned int shader : program.shaders)
+		glDeleteShader(shader);
+	program.shaders.clear();
+}
+
+unsigned int ShaderCompiler::GetProgram(size_t index) const
+{
+	return programs[index].done ? programs[index].id : 0;
+}
+
+bool ShaderCompiler::Succeeded(size_t index) const
+{
+	return programs[index].done && programs[index].success;
+}
+
+unsigned int ShaderCompiler::Release(size_t index)
+{
+	unsigned int id = GetProgram(index);
+	if (programs[index].done)
+		programs[index].id = 0;
+	return id;
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+	for (Program& program : programs)
+	{
+		for (unsigned int shader : program.shaders)
+			glDeleteShader(shader);
+		if (program.id != 0)
+			glDeleteProgram(program.id);
+	}
+}
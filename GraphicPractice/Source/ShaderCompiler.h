@@ -0,0 +1,71 @@
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// GL_KHR_parallel_shader_compile, not part of the generated loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// one stage of a program, the text is not copied and has to stay
+// alive until the batch is submitted
+struct ShaderStageSource
+{
+	GLenum type;
+	std::string_view source;
+};
+
+// Compiles a batch of programs: every stage is submitted before any status
+// is queried, so the driver can work on all of them at the same time
+class ShaderCompiler
+{
+private:
+	struct Program
+	{
+		std::vector<ShaderStageSource> stages;
+		std::vector<unsigned int> shaders;
+		unsigned int id = 0;
+		bool separable = false;
+		bool done = false;
+		bool success = false;
+	};
+	std::vector<Program> programs;
+	bool submitted = false;
+	// compile and link status of a finished program, prints the logs
+	void Collect(Program& program);
+public:
+	ShaderCompiler() = default;
+	// owns GL objects, no copies
+	ShaderCompiler(const ShaderCompiler&) = delete;
+	ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+	// true if the driver compiles in the background (GL_KHR/ARB_parallel_shader_compile)
+	static bool HasParallelCompile();
+	// name of a stage for error messages
+	static const char* StageName(GLenum type);
+
+	// queue programs, returns index of the program in the batch
+	size_t Add(std::string_view vertexSource, std::string_view fragmentSource);
+	// separable programs need GL 4.1, without it they fail like a broken link
+	size_t Add(const std::vector<ShaderStageSource>& stages, bool separable = false);
+	// starts compiling and linking everything that was added
+	void Submit();
+	// non-blocking, true when all programs finished (always true without the extension)
+	bool Poll();
+	// waits for the batch and collects the results
+	void Finish();
+	// program id after Finish, 0 if compile or link failed
+	unsigned int GetProgram(size_t index) const;
+	bool Succeeded(size_t index) const;
+	// gives up ownership of the program, batch will not delete it
+	unsigned int Release(size_t index);
+	size_t Count() const { return programs.size(); }
+	// destructor deletes programs that were not released
+	~ShaderCompiler();
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "ShaderFile.h"
+
+#include <iostream>
+
+static std::string_view TrimLeft(std::string_view text)
+{
+	size_t start = text.find_first_not_of(" \t");
+	return start == std::string_view::npos ? std::string_view() : text.substr(start);
+}
+
+static std::string_view TrimRight(std::string_view text)
+{
+	size_t end = text.find_last_not_of(" \t\r\n");
+	return end == std::string_view::npos ? std::string_view() : text.substr(0, end + 1);
+}
+
+GLenum ShaderFile::StageFromName(std::string_view name)
+{
+	if (name == "vertex") return GL_VERTEX_SHADER;
+	if (name == "fragment" || name == "pixel") return GL_FRAGMENT_SHADER;
+	if (name == "geometry") return GL_GEOMETRY_SHADER;
+	if (name == "tess_control" || name == "tesscontrol") return GL_TESS_CONTROL_SHADER;
+	if (name == "tess_evaluation" || name == "tess_eval" || name == "tesseval") return GL_TESS_EVALUATION_SHADER;
+	if (name == "compute") return GL_COMPUTE_SHADER;
+	return GL_NONE;
+}
+
+bool ShaderFile::Open(const std::string& path, bool looseFirst)
+{
+	stages.clear();
+	if (!(looseFirst ? file.OpenLoose(path) : file.Open(path)))
+	{
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+		return false;
+	}
+	if (!Parse(file.GetView(), stages))
+	{
+		std::cout << "ERROR::SHADER::FILE_PARSE_FAILED " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::string_view ShaderFile::GetStage(GLenum type) const
+{
+	for (const ShaderStageSource& stage : stages)
+	{
+		if (stage.type == type)
+			return stage.source;
+	}
+	return std::string_view();
+}
+
+bool ShaderFile::Parse(std::string_view text, std::vector<ShaderStageSource>& stages)
+{
+	static const std::string_view directive = "#shader";
+	stages.clear();
+	GLenum currentType = GL_NONE;
+	size_t currentStart = 0;
+	size_t lineStart = 0;
+	while (lineStart < text.size())
+	{
+		size_t lineEnd = text.find('\n', lineStart);
+		size_t next = lineEnd == std::string_view::npos ? text.size() : lineEnd + 1;
+		std::string_view line = TrimLeft(text.substr(lineStart, next - lineStart));
+		if (line.compare(0, directive.size(), directive) == 0)
+		{
+			// close the running stage right before this line
+			if (currentType != GL_NONE)
+				stages.push_back({ currentType, text.substr(currentStart, lineStart - currentStart) });
+			std::string_view name = TrimRight(TrimLeft(line.substr(directive.size())));
+			currentType = StageFromName(name);
+			if (currentType == GL_NONE)
+			{
+				std::cout << "ERROR::SHADER::UNKNOWN_STAGE " << name << std::endl;
+				return false;
+			}
+			for (const ShaderStageSource& stage : stages)
+			{
+				if (stage.type == currentType)
+				{
+					std::cout << "ERROR::SHADER::DUPLICATE_STAGE " << name << std::endl;
+					return false;
+				}
+			}
+			currentStart = next;
+		}
+		lineStart = next;
+	}
+	if (currentType != GL_NONE)
+		stages.push_back({ currentType, text.substr(currentStart) });
+	return !stages.empty();
+}
@@ -0,0 +1,30 @@
+#ifndef SHADER_FILE_H
+#define SHADER_FILE_H
+
+#include "AssetFile.h"
+#include "ShaderCompiler.h"
+
+// Multi-stage .shader file split by "#shader <stage>" lines, where stage is
+// vertex, fragment, geometry, tess_control, tess_evaluation or compute.
+// The file is memory mapped (or found in a mounted archive) and scanned once;
+// stages are views into the mapping that go straight to glShaderSource.
+class ShaderFile
+{
+private:
+	AssetFile file;
+	std::vector<ShaderStageSource> stages;
+public:
+	// maps and parses the file, false if it cannot be read or is malformed,
+	// looseFirst reads the file on disk even when a mounted archive has it
+	bool Open(const std::string& path, bool looseFirst = false);
+	// stages in file order, valid while the ShaderFile is alive
+	const std::vector<ShaderStageSource>& GetStages() const { return stages; }
+	// source of one stage, empty if the file has none
+	std::string_view GetStage(GLenum type) const;
+	// splits text that is already in memory, stages point into text
+	static bool Parse(std::string_view text, std::vector<ShaderStageSource>& stages);
+	// stage for a "#shader" name, GL_NONE if unknown
+	static GLenum StageFromName(std::string_view name);
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include "ShaderPreprocessor.h"
+#include "AssetFile.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+// returns the argument of a "#name ..." directive, or false if line is not one
+static bool MatchDirective(std::string_view line, std::string_view name, std::string_view& argument)
+{
+	size_t i = line.find_first_not_of(" \t");
+	if (i == std::string_view::npos || line[i] != '#')
+		return false;
+	i = line.find_first_not_of(" \t", i + 1);
+	if (i == std::string_view::npos)
+		return false;
+	if (line.compare(i, name.size(), name) != 0)
+		return false;
+	size_t end = i + name.size();
+	// "#include" must not match "#included"
+	if (end < line.size() && line[end] != ' ' && line[end] != '\t' && line[end] != '"' && line[end] != '<')
+		return false;
+	size_t start = line.find_first_not_of(" \t", end);
+	argument = start == std::string_view::npos ? std::string_view() : line.substr(start);
+	return true;
+}
+
+std::string ShaderPreprocessor::NormalizePath(const std::string& path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+void ShaderPreprocessor::AddIncludeDirectory(const std::string& directory)
+{
+	includeDirectories.push_back(directory);
+}
+
+std::string ShaderPreprocessor::Resolve(const std::string& name, const std::string& includingFile) const
+{
+	std::filesystem::path local = std::filesystem::path(includingFile).parent_path() / name;
+	if (AssetFile::Exists(local.string()))
+		return NormalizePath(local.string());
+	for (const std::string& directory : includeDirectories)
+	{
+		std::filesystem::path candidate = std::filesystem::path(directory) / name;
+		if (AssetFile::Exists(candidate.string()))
+			return NormalizePath(candidate.string());
+	}
+	return std::string();
+}
+
+PreprocessedShader ShaderPreprocessor::Process(const std::string& path, const std::vector<std::string>& defines)
+{
+	PreprocessedShader result;
+	std::vector<std::string> stack;
+	std::unordered_set<std::string> included;
+	result.success = ProcessFile(NormalizePath(path), result, stack, included, &defines);
+	return result;
+}
+
+bool ShaderPreprocessor::ProcessFile(const std::string& path, PreprocessedShader& result,
+	std::vector<std::string>& stack, std::unordered_set<std::string>& included,
+	const std::vector<std::string>* defines)
+{
+	// the file is scanned straight from the mapping (or archive), only the output is copied
+	AssetFile file;
+	if (!(looseFirst ? file.OpenLoose(path) : file.Open(path)))
+	{
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+		return false;
+	}
+	std::string_view source = file.GetView();
+	result.code.reserve(result.code.size() + source.size());
+	size_t fileIndex = result.files.size();
+	result.files.push_back(path);
+	included.insert(path);
+	stack.push_back(path);
+	std::vector<std::string>& directIncludes = includes[path];
+	directIncludes.clear();
+
+	// defines go right after #version (or at the top if there is none)
+	bool hasVersion = source.find("#version") != std::string_view::npos;
+	auto injectDefines = [&](int nextLine)
+	{
+		for (const std::string& define : *defines)
+			result.code += "#define " + define + "\n";
+		result.code += "#line " + std::to_string(nextLine) + " " + std::to_string(fileIndex) + "\n";
+		defines = nullptr;
+	};
+	if (defines && !hasVersion)
+		injectDefines(1);
+
+	std::string_view argument;
+	int lineNumber = 0;
+	bool success = true;
+	size_t lineStart = 0;
+	while (lineStart < source.size())
+	{
+		size_t lineEnd = source.find('\n', lineStart);
+		if (lineEnd == std::string_view::npos)
+			lineEnd = source.size();
+		std::string_view line = source.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+		lineNumber++;
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+
+		if (MatchDirective(line, "version", argument))
+		{
+			// only the top level file keeps its #version
+			if (stack.size() == 1)
+			{
+				result.code.append(line).append("\n");
+				if (defines)
+					injectDefines(lineNumber + 1);
+			}
+			else
+				result.code += "\n";
+			continue;
+		}
+		if (MatchDirective(line, "pragma", argument) && argument.compare(0, 4, "once") == 0)
+		{
+			// every file is included once anyway
+			result.code += "\n";
+			continue;
+		}
+		if (!MatchDirective(line, "include", argument))
+		{
+			result.code.append(line).append("\n");
+			continue;
+		}
+
+		// #include "name" or #include <name>
+		size_t open = argument.find_first_of("\"<");
+		size_t close = open == std::string_view::npos ? open : argument.find_first_of("\">", open + 1);
+		if (close == std::string_view::npos)
+		{
+			std::cout << "ERROR::SHADER::PREPROCESSOR::BAD_INCLUDE " << path << ":" << lineNumber << std::endl;
+			success = false;
+			continue;
+		}
+		std::string name(argument.substr(open + 1, close - open - 1));
+		std::string includePath = Resolve(name, path);
+		if (includePath.empty())
+		{
+			std::cout << "ERROR::SHADER::PREPROCESSOR::INCLUDE_NOT_FOUND " << name
+				<< " in " << path << ":" << lineNumber << std::endl;
+			success = false;
+			continue;
+		}
+		directIncludes.push_back(includePath);
+		if (std::find(stack.begin(), stack.end(), includePath) != stack.end())
+		{
+			std::cout << "ERROR::SHADER::PREPROCESSOR::INCLUDE_CYCLE " << includePath
+				<< " in " << path << ":" << lineNumber << std::endl;
+			success = false;
+			continue;
+		}
+		if (included.count(includePath))
+		{
+			result.code += "\n";
+			continue;
+		}
+		result.code += "#line 1 " + std::to_string(result.files.size()) + "\n";
+		success &= ProcessFile(includePath, result, stack, included, nullptr);
+		// back to the including file
+		result.code += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+	}
+	stack.pop_back();
+	return success;
+}
+
+bool ShaderPreprocessor::DependsOn(const std::string& path, const std::string& file) const
+{
+	std::string target = NormalizePath(file);
+	std::vector<std::string> open = { NormalizePath(path) };
+	std::unordered_set<std::string> visited;
+	while (!open.empty())
+	{
+		std::string current = open.back();
+		open.pop_back();
+		if (current == target)
+			return true;
+		if (!visited.insert(current).second)
+			continue;
+		auto it = includes.find(current);
+		if (it != includes.end())
+			open.insert(open.end(), it->second.begin(), it->second.end());
+	}
+	return false;
+}
@@ -0,0 +1,47 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// result of preprocessing one shader file
+struct PreprocessedShader
+{
+	std::string code;
+	// every file the code was built from, the index is the source number used in #line
+	std::vector<std::string> files;
+	bool success = false;
+};
+
+// Resolves #include "file" and injects #define sets before compiling.
+// Every file is included at most once per shader, so headers need no
+// guards of their own, and include cycles are reported as errors.
+class ShaderPreprocessor
+{
+private:
+	std::vector<std::string> includeDirectories;
+	// dependency graph: file -> files it includes directly
+	std::unordered_map<std::string, std::vector<std::string>> includes;
+	bool looseFirst = false;
+
+	bool ProcessFile(const std::string& path, PreprocessedShader& result,
+		std::vector<std::string>& stack, std::unordered_set<std::string>& included,
+		const std::vector<std::string>* defines);
+	// finds an included file next to the including one or in the include directories
+	std::string Resolve(const std::string& name, const std::string& includingFile) const;
+public:
+	// normalized path used as the key of the dependency graph
+	static std::string NormalizePath(const std::string& path);
+	// extra directories searched by #include
+	void AddIncludeDirectory(const std::string& directory);
+	// read files on disk before a mounted archive, the watcher reloads edited loose files
+	void SetLooseFirst(bool loose) { looseFirst = loose; }
+	// defines are "NAME" or "NAME VALUE", placed right after #version
+	PreprocessedShader Process(const std::string& path, const std::vector<std::string>& defines = {});
+	// true if file is path itself or included by it, directly or indirectly
+	bool DependsOn(const std::string& path, const std::string& file) const;
+};
+
+#endif
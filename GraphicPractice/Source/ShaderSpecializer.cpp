@@ -0,0 +1,174 @@
+#include "ShaderSpecializer.h"
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <regex>
+
+ShaderSpecializer::ShaderSpecializer(Shader& generic, int stableFrames)
+	: generic(generic), stableFrames(stableFrames), genericRevision(generic.GetRevision())
+{
+	Reset();
+}
+
+bool ShaderSpecializer::CanFreeze(const Shader::UniformSlot& slot)
+{
+	// samplers only pick a texture unit, there is nothing to fold;
+	// arrays and struct members are left alone too
+	return slot.kind != GL_NONE &&
+		(slot.type == GL_FLOAT || slot.type == GL_INT || slot.type == GL_BOOL) &&
+		slot.name.find_first_of("[.") == std::string::npos;
+}
+
+std::string ShaderSpecializer::ConstantDeclaration(const Shader::UniformSlot& slot)
+{
+	char value[32];
+	if (slot.type == GL_FLOAT)
+	{
+		float f;
+		memcpy(&f, &slot.bits, sizeof(f));
+		if (!std::isfinite(f))
+			return std::string();
+		// enough digits to get the exact float back
+		snprintf(value, sizeof(value), "%.9g", f);
+		if (!strpbrk(value, ".e"))
+			strcat(value, ".0");
+		return "const float " + slot.name + " = " + value + ";";
+	}
+	if (slot.type == GL_BOOL)
+		return "const bool " + slot.name + " = " + (slot.bits ? "true" : "false") + ";";
+	snprintf(value, sizeof(value), "%d", (int)slot.bits);
+	return "const int " + slot.name + " = " + value + ";";
+}
+
+void ShaderSpecializer::Reset()
+{
+	active = nullptr;
+	size_t count = generic.GetUniformSlots().size();
+	lastChanges.assign(count, 0);
+	unchangedFrames.assign(count, 0);
+	for (size_t i = 0; i < count; i++)
+		lastChanges[i] = generic.GetUniformSlots()[i].changes;
+}
+
+void ShaderSpecializer::EndFrame()
+{
+	// a reload relinks the generic program and invalidates every variant
+	if (generic.GetRevision() != genericRevision)
+	{
+		genericRevision = generic.GetRevision();
+		variants.clear();
+		Reset();
+		return;
+	}
+	const std::vector<Shader::UniformSlot>& slots = generic.GetUniformSlots();
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		if (slots[i].changes != lastChanges[i])
+		{
+			lastChanges[i] = slots[i].changes;
+			unchangedFrames[i] = 0;
+		}
+		else if (unchangedFrames[i] < stableFrames)
+			unchangedFrames[i]++;
+	}
+}
+
+bool ShaderSpecializer::StillValid(const Variant& variant) const
+{
+	const std::vector<Shader::UniformSlot>& slots = generic.GetUniformSlots();
+	for (size_t i = 0; i < variant.frozenSlots.size(); i++)
+	{
+		if (slots[variant.frozenSlots[i]].changes != variant.frozenChanges[i])
+			return false;
+	}
+	return true;
+}
+
+ShaderSpecializer::Variant* ShaderSpecializer::Specialize()
+{
+	const std::vector<Shader::UniformSlot>& slots = generic.GetUniformSlots();
+	std::vector<int> frozen;
+	std::string key;
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		// a value set during this frame does not count as stable yet
+		bool stable = unchangedFrames[i] >= stableFrames && slots[i].changes == lastChanges[i];
+		if (stable && CanFreeze(slots[i]) && !ConstantDeclaration(slots[i]).empty())
+		{
+			frozen.push_back((int)i);
+			key += ConstantDeclaration(slots[i]);
+		}
+	}
+	if (frozen.empty())
+		return nullptr;
+
+	auto it = variants.find(key);
+	if (it == variants.end())
+	{
+		if (variants.size() >= maxVariants || generic.GetFragmentPath().empty())
+			return nullptr;
+		// turn "uniform <type> <name>;" into a constant in both stages
+		ShaderPreprocessor preprocessor;
+		PreprocessedShader vertex = preprocessor.Process(generic.GetVertexPath());
+		PreprocessedShader fragment = preprocessor.Process(generic.GetFragmentPath());
+		if (!vertex.success || !fragment.success)
+			return nullptr;
+		Variant variant;
+		for (int slot : frozen)
+		{
+			std::regex declaration("uniform\\s+(?:(?:lowp|mediump|highp)\\s+)?\\w+\\s+" + slots[slot].name + "\\s*;");
+			std::string constant = ConstantDeclaration(slots[slot]);
+			std::string newVertex = std::regex_replace(vertex.code, declaration, constant);
+			std::string newFragment = std::regex_replace(fragment.code, declaration, constant);
+			// declared some other way (e.g. "uniform float a, b;"), leave it a uniform
+			if (newVertex == vertex.code && newFragment == fragment.code)
+				continue;
+			vertex.code = newVertex;
+			fragment.code = newFragment;
+			variant.frozenSlots.push_back(slot);
+		}
+		unsigned int program = variant.frozenSlots.empty() ? 0 : Shader::BuildProgram(vertex.code, fragment.code);
+		// remember failures too, so the same set is not compiled every frame
+		if (program != 0)
+			variant.shader.reset(new Shader(program));
+		it = variants.emplace(key, std::move(variant)).first;
+	}
+	Variant& variant = it->second;
+	if (!variant.shader)
+		return nullptr;
+	variant.frozenChanges.clear();
+	for (int slot : variant.frozenSlots)
+		variant.frozenChanges.push_back(slots[slot].changes);
+	variant.slotMap.assign(slots.size(), -1);
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		if (std::find(variant.frozenSlots.begin(), variant.frozenSlots.end(), (int)i) == variant.frozenSlots.end())
+			variant.slotMap[i] = variant.shader->GetUniform(slots[i].name).slot;
+	}
+	return &variant;
+}
+
+Shader& ShaderSpecializer::Prepare()
+{
+	if (active && !StillValid(*active))
+	{
+		// a frozen value changed, back to the generic program until things settle again
+		active = nullptr;
+	}
+	if (!active)
+		active = Specialize();
+	if (!active)
+		return generic;
+
+	// the live uniforms are set on the generic shader, copy them over
+	const std::vector<Shader::UniformSlot>& slots = generic.GetUniformSlots();
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		if (active->slotMap[i] != -1 && slots[i].kind != GL_NONE)
+			active->shader->StageUniform(active->slotMap[i], slots[i].kind, slots[i].bits);
+	}
+	return *active->shader;
+}
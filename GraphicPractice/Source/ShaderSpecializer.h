@@ -0,0 +1,59 @@
+#ifndef SHADER_SPECIALIZER_H
+#define SHADER_SPECIALIZER_H
+
+#include "Shader.h"
+
+#include <map>
+#include <memory>
+
+// Watches the uniforms of a vertex/fragment Shader and, once some scalar
+// uniforms kept the same value for a number of frames, builds a variant in
+// which they are compile time constants the driver can fold. Prepare()
+// picks that variant while the values hold and falls back to the generic
+// program as soon as one of them changes.
+// Uniforms are always set on the generic shader; draw with what Prepare returns.
+class ShaderSpecializer
+{
+private:
+	struct Variant
+	{
+		std::unique_ptr<Shader> shader;
+		// generic slots baked into the variant
+		std::vector<int> frozenSlots;
+		// change counters of the frozen slots when the variant was built
+		std::vector<unsigned int> frozenChanges;
+		// generic slot -> slot in the variant, -1 when frozen or missing
+		std::vector<int> slotMap;
+	};
+
+	Shader& generic;
+	int stableFrames;
+	unsigned int genericRevision;
+	std::vector<unsigned int> lastChanges;
+	std::vector<int> unchangedFrames;
+	// variants by their baked values, so toggling values reuses programs
+	std::map<std::string, Variant> variants;
+	Variant* active = nullptr;
+
+	// uniforms that can be turned into constants
+	static bool CanFreeze(const Shader::UniformSlot& slot);
+	// "const <type> <name> = <value>;" for a slot, empty if the value cannot be written
+	static std::string ConstantDeclaration(const Shader::UniformSlot& slot);
+	void Reset();
+	bool StillValid(const Variant& variant) const;
+	// builds (or reuses) a variant for the currently stable uniforms
+	Variant* Specialize();
+public:
+	// at most this many different variants are built per shader
+	static const size_t maxVariants = 8;
+
+	// generic must be built from vertex/fragment files and outlive the specializer
+	explicit ShaderSpecializer(Shader& generic, int stableFrames = 120);
+	// call once per frame, after the uniforms of the frame were set
+	void EndFrame();
+	// program to draw with, the live uniforms are already copied into it; use() and Flush() it as usual
+	Shader& Prepare();
+	bool IsSpecialized() const { return active != nullptr; }
+};
+
+#endif
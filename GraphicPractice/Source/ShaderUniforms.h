@@ -0,0 +1,35 @@
+// Generated by Tools/ShaderReflect, do not edit.
+// Run it again after changing uniforms in the shaders below.
+#ifndef SHADERUNIFORMS_H
+#define SHADERUNIFORMS_H
+
+#include "ReflectedUniform.h"
+
+// Resources/Shaders/vertex.shader, Resources/Shaders/fragment.shader
+struct MainUniforms
+{
+	ReflectedUniform<int, UniformNameHash("texture1")> texture1; // sampler2D
+	ReflectedUniform<int, UniformNameHash("texture2")> texture2; // sampler2D
+
+	// resolves every uniform once, again after the shader was reloaded
+	bool Bind(const Shader& shader)
+	{
+		bool found = true;
+		found &= texture1.Bind(shader);
+		found &= texture2.Bind(shader);
+		return found;
+	}
+
+	// uniforms the last Bind did not find, for the error message
+	std::vector<const char*> Missing() const
+	{
+		std::vector<const char*> missing;
+		if (!texture1.handle.IsValid())
+			missing.push_back("texture1");
+		if (!texture2.handle.IsValid())
+			missing.push_back("texture2");
+		return missing;
+	}
+};
+
+#endif
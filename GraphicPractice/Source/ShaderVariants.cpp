@@ -0,0 +1,100 @@
+#include "ShaderVariants.h"
+
+ShaderVariants::ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath,
+	const std::vector<std::string>& features)
+	: vertexPath(vertexPath), fragmentPath(fragmentPath), features(features)
+{
+	if (this->features.size() > 32)
+	{
+		std::cout << "ERROR::SHADER_VARIANTS::TOO_MANY_FEATURES " << features.size() << std::endl;
+		this->features.resize(32);
+	}
+}
+
+uint32_t ShaderVariants::FeatureBit(const std::string& feature) const
+{
+	for (size_t i = 0; i < features.size(); i++)
+	{
+		if (features[i] == feature)
+			return 1u << i;
+	}
+	return 0;
+}
+
+std::vector<std::string> ShaderVariants::DefinesFor(uint32_t mask) const
+{
+	std::vector<std::string> defines;
+	for (size_t i = 0; i < features.size(); i++)
+	{
+		if (mask & (1u << i))
+			defines.push_back(features[i]);
+	}
+	return defines;
+}
+
+unsigned int ShaderVariants::Build(uint32_t mask)
+{
+	std::vector<std::string> defines = DefinesFor(mask);
+	PreprocessedShader vertex = preprocessor.Process(vertexPath, defines);
+	PreprocessedShader fragment = preprocessor.Process(fragmentPath, defines);
+	if (!vertex.success || !fragment.success)
+		return 0;
+	return Shader::BuildProgram(vertex.code, fragment.code);
+}
+
+Shader& ShaderVariants::Get(uint32_t mask)
+{
+	auto it = variants.find(mask);
+	if (it != variants.end())
+		return *it->second;
+	// a failed variant is kept too (program 0) so it is not rebuilt every frame
+	std::unique_ptr<Shader>& shader = variants[mask];
+	shader.reset(new Shader(Build(mask)));
+	return *shader;
+}
+
+std::vector<WarmupRequest> ShaderVariants::MakeWarmupRequests(const std::vector<uint32_t>& masks) const
+{
+	std::vector<WarmupRequest> manifest;
+	for (uint32_t mask : masks)
+	{
+		if (variants.count(mask))
+			continue;
+		WarmupRequest request;
+		request.vertexPath = vertexPath;
+		request.fragmentPath = fragmentPath;
+		request.defines = DefinesFor(mask);
+		request.tag = mask;
+		manifest.push_back(request);
+	}
+	return manifest;
+}
+
+void ShaderVariants::Adopt(uint32_t mask, unsigned int program)
+{
+	// a failed warm-up is left to Get, which reports the errors
+	if (program == 0)
+		return;
+	if (variants.count(mask))
+	{
+		glDeleteProgram(program);
+		return;
+	}
+	variants[mask].reset(new Shader(program));
+}
+
+int ShaderVariants::Reload(const std::string& changedPath)
+{
+	if (!preprocessor.DependsOn(vertexPath, changedPath) && !preprocessor.DependsOn(fragmentPath, changedPath))
+		return 0;
+	int reloaded = 0;
+	for (auto& variant : variants)
+	{
+		unsigned int program = Build(variant.first);
+		if (program == 0)
+			continue;
+		variant.second->SwapProgram(program);
+		reloaded++;
+	}
+	return reloaded;
+}
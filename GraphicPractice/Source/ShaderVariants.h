@@ -0,0 +1,42 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderWarmup.h"
+
+#include <cstdint>
+#include <memory>
+
+// Permutations of one vertex/fragment pair. Feature i is turned on by bit i
+// of the mask and becomes "#define <feature>" in both stages; every mask is
+// compiled once on first use and cached.
+class ShaderVariants
+{
+private:
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::vector<std::string> features;
+	ShaderPreprocessor preprocessor;
+	std::unordered_map<uint32_t, std::unique_ptr<Shader>> variants;
+
+	std::vector<std::string> DefinesFor(uint32_t mask) const;
+	unsigned int Build(uint32_t mask);
+public:
+	// at most 32 features
+	ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath,
+		const std::vector<std::string>& features);
+	// bit of a feature, 0 if unknown
+	uint32_t FeatureBit(const std::string& feature) const;
+	// compiles the variant on first use
+	Shader& Get(uint32_t mask);
+	// manifest for ShaderWarmup, the tag of each request is its mask
+	std::vector<WarmupRequest> MakeWarmupRequests(const std::vector<uint32_t>& masks) const;
+	// takes a program built by ShaderWarmup, ignored if the variant already exists
+	void Adopt(uint32_t mask, unsigned int program);
+	// rebuilds variants that use the changed file, old programs stay on failure
+	int Reload(const std::string& changedPath);
+	size_t Count() const { return variants.size(); }
+};
+
+#endif
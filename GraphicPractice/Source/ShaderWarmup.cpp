@@ -0,0 +1,107 @@
+#include "ShaderWarmup.h"
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+
+ShaderWarmup::ShaderWarmup(GLFWwindow* mainWindow)
+	: running(true)
+{
+	// invisible window, only its context (sharing objects with mainWindow) is used
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	context = glfwCreateWindow(1, 1, "ShaderWarmup", NULL, mainWindow);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	if (context == NULL)
+	{
+		std::cout << "ERROR::SHADER_WARMUP::CONTEXT_CREATION_FAILED" << std::endl;
+		return;
+	}
+	worker = std::thread(&ShaderWarmup::Run, this);
+}
+
+ShaderWarmup::~ShaderWarmup()
+{
+	if (context == NULL)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	wakeUp.notify_one();
+	worker.join();
+	// programs nobody picked up
+	WarmupResult* result;
+	while ((result = results.Front()) != nullptr)
+	{
+		glDeleteSync(result->fence);
+		glDeleteProgram(result->program);
+		results.Pop();
+	}
+	glfwDestroyWindow(context);
+}
+
+void ShaderWarmup::Enqueue(const std::vector<WarmupRequest>& manifest)
+{
+	if (context == NULL)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		requests.insert(requests.end(), manifest.begin(), manifest.end());
+	}
+	wakeUp.notify_one();
+}
+
+void ShaderWarmup::Run()
+{
+	glfwMakeContextCurrent(context);
+	ShaderPreprocessor preprocessor;
+	while (true)
+	{
+		WarmupRequest request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [this]() { return !running || !requests.empty(); });
+			if (!running)
+				break;
+			request = std::move(requests.front());
+			requests.pop_front();
+		}
+
+		WarmupResult result;
+		result.tag = request.tag;
+		PreprocessedShader vertex = preprocessor.Process(request.vertexPath, request.defines);
+		PreprocessedShader fragment = preprocessor.Process(request.fragmentPath, request.defines);
+		if (vertex.success && fragment.success)
+			result.program = Shader::BuildProgram(vertex.code, fragment.code);
+		// the render thread must not use the program before the driver finished it
+		result.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+
+		// results are only dropped if the render thread stops polling
+		while (!results.Push(result))
+		{
+			if (!running)
+			{
+				glDeleteSync(result.fence);
+				glDeleteProgram(result.program);
+				break;
+			}
+			std::this_thread::yield();
+		}
+	}
+	glfwMakeContextCurrent(NULL);
+}
+
+bool ShaderWarmup::Poll(WarmupResult& result)
+{
+	WarmupResult* front = results.Front();
+	if (front == nullptr)
+		return false;
+	// zero timeout, a program still in flight stays queued
+	GLenum status = glClientWaitSync(front->fence, 0, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		return false;
+	glDeleteSync(front->fence);
+	result = *front;
+	result.fence = 0;
+	results.Pop();
+	return true;
+}
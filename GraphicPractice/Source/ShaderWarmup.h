@@ -0,0 +1,66 @@
+#ifndef SHADER_WARMUP_H
+#define SHADER_WARMUP_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// one program to precompile
+struct WarmupRequest
+{
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::vector<std::string> defines;
+	// handed back with the result, e.g. the variant mask
+	uint64_t tag = 0;
+};
+
+struct WarmupResult
+{
+	uint64_t tag = 0;
+	// 0 if compile or link failed
+	unsigned int program = 0;
+	GLsync fence = 0;
+};
+
+// Compiles and links programs on a worker thread with its own GL context
+// shared with the main one, so new variants are ready before first use.
+// Finished programs come back through a lock-free queue; the render thread
+// never waits on the worker.
+class ShaderWarmup
+{
+private:
+	GLFWwindow* context = nullptr;
+	std::thread worker;
+	std::atomic<bool> running;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::deque<WarmupRequest> requests;
+	SpscQueue<WarmupResult, 256> results;
+
+	void Run();
+public:
+	// must be called on the main thread (GLFW creates windows there only)
+	explicit ShaderWarmup(GLFWwindow* mainWindow);
+	~ShaderWarmup();
+	ShaderWarmup(const ShaderWarmup&) = delete;
+	ShaderWarmup& operator=(const ShaderWarmup&) = delete;
+
+	bool IsValid() const { return context != nullptr; }
+	// adds a manifest of programs, e.g. at startup or level load
+	void Enqueue(const std::vector<WarmupRequest>& manifest);
+	// render thread: takes one finished program the GPU can use, false if none is ready
+	bool Poll(WarmupResult& result);
+};
+
+#endif
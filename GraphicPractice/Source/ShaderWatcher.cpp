@@ -0,0 +1,322 @@
+#include "ShaderWatcher.h"
+#include "ProgramCache.h"
+#include "ShaderFile.h"
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// how often the worker checks for changes or for shutdown
+static const int watchIntervalMs = 200;
+
+// absolute, so the files of an entry compare equal to directory + name from inotify
+static std::filesystem::path WatchedPath(const std::filesystem::path& path)
+{
+	std::error_code error;
+	return ShaderPreprocessor::NormalizePath(std::filesystem::absolute(path, error).string());
+}
+
+static std::filesystem::file_time_type WriteTime(const std::filesystem::path& path)
+{
+	std::error_code error;
+	return std::filesystem::last_write_time(path, error);
+}
+
+ShaderWatcher::ShaderWatcher()
+	: running(true)
+{
+#ifdef __linux__
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd == -1)
+		std::cout << "ERROR::SHADER_WATCHER::INOTIFY_INIT_FAILED, falling back to polling" << std::endl;
+#endif
+	worker = std::thread(&ShaderWatcher::Run, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+	running = false;
+	worker.join();
+#ifdef __linux__
+	if (inotifyFd != -1)
+		close(inotifyFd);
+#endif
+}
+
+void ShaderWatcher::AddWatch(const std::filesystem::path& directory)
+{
+#ifdef __linux__
+	// watch the directory: editors often save by renaming a temporary file
+	if (inotifyFd == -1)
+		return;
+	// a watch on the same directory twice just returns the existing descriptor,
+	// no IN_CREATE: a new file is still empty then and its IN_CLOSE_WRITE follows
+	int descriptor = inotify_add_watch(inotifyFd, directory.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (descriptor != -1)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		watchDirectories[descriptor] = directory;
+	}
+#endif
+}
+
+void ShaderWatcher::SetFiles(Entry& entry, const std::vector<std::string>& files)
+{
+	entry.files.clear();
+	entry.times.clear();
+	for (const std::string& file : files)
+	{
+		std::filesystem::path path = WatchedPath(file);
+		if (std::find(entry.files.begin(), entry.files.end(), path) != entry.files.end())
+			continue;
+		entry.files.push_back(path);
+		entry.times.push_back(WriteTime(path));
+		AddWatch(path.parent_path());
+	}
+}
+
+void ShaderWatcher::Watch(Shader& shader)
+{
+	Entry entry;
+	entry.shader = &shader;
+	entry.vertexPath = WatchedPath(shader.GetVertexPath());
+	entry.stageType = shader.GetStageType();
+	entry.defines = shader.GetDefines();
+	if (!shader.GetFragmentPath().empty())
+		entry.fragmentPath = WatchedPath(shader.GetFragmentPath());
+	std::vector<std::string> files = shader.GetDependencies();
+	files.push_back(shader.GetVertexPath());
+	if (!shader.GetFragmentPath().empty())
+		files.push_back(shader.GetFragmentPath());
+	SetFiles(entry, files);
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.push_back(entry);
+}
+
+void ShaderWatcher::Unwatch(Shader& shader)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.erase(std::remove_if(entries.begin(), entries.end(),
+		[&](const Entry& e) { return e.shader == &shader; }), entries.end());
+	pending.erase(std::remove_if(pending.begin(), pending.end(),
+		[&](const PendingReload& p) { return p.shader == &shader; }), pending.end());
+	jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+		[&](const Job& j) { return j.shader == &shader; }), jobs.end());
+}
+
+void ShaderWatcher::Run()
+{
+	while (running)
+	{
+#ifdef __linux__
+		if (inotifyFd != -1)
+		{
+			pollfd fd = { inotifyFd, POLLIN, 0 };
+			if (poll(&fd, 1, watchIntervalMs) <= 0)
+				continue;
+			alignas(inotify_event) char buffer[4096];
+			ssize_t length;
+			while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+			{
+				// one read can return several events
+				for (char* ptr = buffer; ptr < buffer + length; )
+				{
+					const inotify_event* event = (const inotify_event*)ptr;
+					ptr += sizeof(inotify_event) + event->len;
+					if (event->len == 0)
+						continue;
+					std::filesystem::path directory;
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						auto it = watchDirectories.find(event->wd);
+						if (it == watchDirectories.end())
+							continue;
+						directory = it->second;
+					}
+					OnChanged(WatchedPath(directory / event->name));
+				}
+			}
+			continue;
+		}
+#endif
+		std::this_thread::sleep_for(std::chrono::milliseconds(watchIntervalMs));
+		OnChanged(std::filesystem::path());
+	}
+}
+
+void ShaderWatcher::OnChanged(const std::filesystem::path& path)
+{
+	// copy the entries so no file is read while holding the lock
+	std::vector<Entry> current;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		current = entries;
+	}
+	for (Entry& entry : current)
+	{
+		bool touched = false;
+		for (size_t i = 0; i < entry.files.size() && !touched; i++)
+		{
+			if (path.empty())
+				touched = WriteTime(entry.files[i]) != entry.times[i];
+			else
+				touched = entry.files[i] == path;
+		}
+		if (!touched)
+			continue;
+
+		PendingReload reload;
+		reload.shader = entry.shader;
+		bool success;
+		std::vector<std::string> files;
+		// the edit is in the loose file, a mounted archive still holds the old copy
+		if (entry.stageType != GL_NONE)
+		{
+			ShaderPreprocessor preprocessor;
+			preprocessor.SetLooseFirst(true);
+			PreprocessedShader source = preprocessor.Process(entry.vertexPath.string(), entry.defines);
+			success = source.success;
+			files = source.files;
+			reload.types = { entry.stageType };
+			reload.codes = { std::move(source.code) };
+			reload.separable = true;
+		}
+		else if (entry.fragmentPath.empty())
+		{
+			// multi-stage file, the read buffer goes away with file so the stages are copied
+			ShaderFile file;
+			success = file.Open(entry.vertexPath.string(), true);
+			for (const ShaderStageSource& stage : file.GetStages())
+			{
+				reload.types.push_back(stage.type);
+				reload.codes.emplace_back(stage.source);
+			}
+		}
+		else
+		{
+			// includes may have changed too, so the file list is rebuilt
+			ShaderPreprocessor preprocessor;
+			preprocessor.SetLooseFirst(true);
+			PreprocessedShader vertex = preprocessor.Process(entry.vertexPath.string());
+			PreprocessedShader fragment = preprocessor.Process(entry.fragmentPath.string());
+			success = vertex.success && fragment.success;
+			files = vertex.files;
+			files.insert(files.end(), fragment.files.begin(), fragment.files.end());
+			files.push_back(entry.fragmentPath.string());
+			reload.types = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+			reload.codes = { std::move(vertex.code), std::move(fragment.code) };
+		}
+		// keep watching the sources even if they could not be read
+		files.push_back(entry.vertexPath.string());
+		SetFiles(entry, files);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (Entry& e : entries)
+		{
+			if (e.shader == entry.shader)
+			{
+				e.files = entry.files;
+				e.times = entry.times;
+			}
+		}
+		if (!success)
+		{
+			std::cout << "ERROR::SHADER_WATCHER::RELOAD_FAILED " << entry.vertexPath
+				<< " " << entry.fragmentPath << std::endl;
+			continue;
+		}
+		// only the newest version of a shader matters
+		auto it = std::find_if(pending.begin(), pending.end(),
+			[&](const PendingReload& p) { return p.shader == reload.shader; });
+		if (it != pending.end())
+			*it = std::move(reload);
+		else
+			pending.push_back(std::move(reload));
+	}
+}
+
+bool ShaderWatcher::Complete(Job& job)
+{
+	if (!job.compiler->Succeeded(job.index))
+	{
+		// keep rendering with the old program
+		std::cout << "ERROR::SHADER_WATCHER::RELOAD_FAILED " << job.shader->GetVertexPath()
+			<< " " << job.shader->GetFragmentPath() << std::endl;
+		return false;
+	}
+	unsigned int program = job.compiler->Release(job.index);
+	if (!job.cacheKey.empty())
+		ProgramCache::Store(job.cacheKey, program);
+	job.shader->SwapProgram(program);
+	std::cout << "Reloaded shader " << job.shader->GetVertexPath() << " "
+		<< job.shader->GetFragmentPath() << std::endl;
+	return true;
+}
+
+bool ShaderWatcher::Update(double budgetMs)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto elapsedMs = [&]() {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+	bool swapped = false;
+
+	// 1. pick up compiles that finished in the background
+	for (size_t i = 0; i < jobs.size(); )
+	{
+		if (jobs[i].compiler->Poll())
+		{
+			swapped |= Complete(jobs[i]);
+			jobs.erase(jobs.begin() + i);
+		}
+		else
+			i++;
+	}
+
+	// 2. start new compiles while there is time left in this frame
+	while (elapsedMs() < budgetMs)
+	{
+		PendingReload reload;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (pending.empty())
+				break;
+			reload = std::move(pending.front());
+			pending.erase(pending.begin());
+		}
+		// a newer edit replaces a compile that is still running
+		jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+			[&](const Job& j) { return j.shader == reload.shader; }), jobs.end());
+
+		Job job;
+		job.shader = reload.shader;
+		// the driver copies the sources in Submit, reload only has to live until then
+		std::vector<ShaderStageSource> stages;
+		std::vector<std::string_view> sources;
+		for (size_t i = 0; i < reload.codes.size(); i++)
+		{
+			stages.push_back({ reload.types[i], reload.codes[i] });
+			sources.push_back(reload.codes[i]);
+		}
+		// same key as Shader::BuildProgram
+		if (reload.separable)
+			sources.push_back("#separable");
+		if (ProgramCache::IsSupported())
+			job.cacheKey = ProgramCache::MakeKey(sources);
+		job.compiler.reset(new ShaderCompiler());
+		job.index = job.compiler->Add(stages, reload.separable);
+		job.compiler->Submit();
+		// without parallel compile this blocks, so the job is done right away
+		if (job.compiler->Poll())
+			swapped |= Complete(job);
+		else
+			jobs.push_back(std::move(job));
+	}
+	return swapped;
+}
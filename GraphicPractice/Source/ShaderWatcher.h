@@ -0,0 +1,86 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include "Shader.h"
+#include "ShaderCompiler.h"
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Reloads shaders when their files change on disk.
+// A worker thread waits for changes (inotify on Linux, timestamp polling
+// elsewhere) and reads the new sources; Update() on the render thread
+// preprocesses and compiles them and swaps the program behind the Shader object.
+class ShaderWatcher
+{
+private:
+	struct Entry
+	{
+		Shader* shader;
+		std::filesystem::path vertexPath;
+		// empty for multi-stage .shader files and stage programs
+		std::filesystem::path fragmentPath;
+		// stage programs (Shader::GetStageType) are rebuilt from one file with their defines
+		GLenum stageType = GL_NONE;
+		std::vector<std::string> defines;
+		// sources and everything they include, with their last write time
+		std::vector<std::filesystem::path> files;
+		std::vector<std::filesystem::file_time_type> times;
+	};
+	// sources read by the worker, waiting for the render thread
+	struct PendingReload
+	{
+		Shader* shader;
+		std::vector<GLenum> types;
+		std::vector<std::string> codes;
+		// relinked as a separable program, so it can stay attached to pipelines
+		bool separable = false;
+	};
+	// compile in flight on the render thread
+	struct Job
+	{
+		Shader* shader;
+		std::string cacheKey;
+		std::unique_ptr<ShaderCompiler> compiler;
+		size_t index;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<PendingReload> pending;
+	std::vector<Job> jobs;
+	std::mutex mutex;
+	std::atomic<bool> running;
+	std::thread worker;
+	int inotifyFd = -1;
+	// directory of every inotify watch descriptor, events only carry the file name
+	std::unordered_map<int, std::filesystem::path> watchDirectories;
+
+	void Run();
+	// re-reads the files of every entry touching path (an absolute, normalized path),
+	// any entry whose files changed if path is empty
+	void OnChanged(const std::filesystem::path& path);
+	void AddWatch(const std::filesystem::path& directory);
+	// remembers the files of an entry and watches their directories
+	void SetFiles(Entry& entry, const std::vector<std::string>& files);
+	// finishes a job, returns true if the shader got a new program
+	bool Complete(Job& job);
+public:
+	ShaderWatcher();
+	~ShaderWatcher();
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+	// start watching the source files of a shader (must outlive the watch)
+	void Watch(Shader& shader);
+	void Unwatch(Shader& shader);
+	// render thread: compiles pending reloads within budgetMs,
+	// returns true if any shader was swapped this frame
+	bool Update(double budgetMs = 2.0);
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "SkylinePacker.h"
+
+#include <algorithm>
+#include <numeric>
+
+SkylinePacker::SkylinePacker(int width, int height)
+	: width(width), height(height)
+{
+	Reset();
+}
+
+void SkylinePacker::Reset()
+{
+	skyline.assign(1, Node{ 0, 0, width });
+}
+
+int SkylinePacker::FitAt(size_t index, int rectWidth, int rectHeight) const
+{
+	int x = skyline[index].x;
+	if (x + rectWidth > width)
+		return -1;
+	// the rectangle rests on the highest node it spans
+	int y = 0;
+	int remaining = rectWidth;
+	for (size_t i = index; remaining > 0; i++)
+	{
+		if (i == skyline.size())
+			return -1;
+		y = std::max(y, skyline[i].y);
+		if (y + rectHeight > height)
+			return -1;
+		remaining -= skyline[i].width;
+	}
+	return y;
+}
+
+bool SkylinePacker::Insert(int rectWidth, int rectHeight, PackedRect& rect)
+{
+	if (rectWidth <= 0 || rectHeight <= 0)
+		return false;
+	size_t best = skyline.size();
+	int bestTop = height + 1;
+	int bestWidth = width + 1;
+	int bestY = 0;
+	for (size_t i = 0; i < skyline.size(); i++)
+	{
+		int y = FitAt(i, rectWidth, rectHeight);
+		if (y < 0)
+			continue;
+		// lowest top edge first, narrower resting node breaks ties
+		if (y + rectHeight < bestTop || (y + rectHeight == bestTop && skyline[i].width < bestWidth))
+		{
+			best = i;
+			bestTop = y + rectHeight;
+			bestWidth = skyline[i].width;
+			bestY = y;
+		}
+	}
+	if (best == skyline.size())
+		return false;
+
+	rect.x = skyline[best].x;
+	rect.y = bestY;
+	rect.width = rectWidth;
+	rect.height = rectHeight;
+
+	// the new node covers the rectangle, nodes under it shrink or disappear
+	skyline.insert(skyline.begin() + best, Node{ rect.x, bestTop, rectWidth });
+	int right = rect.x + rectWidth;
+	size_t i = best + 1;
+	while (i < skyline.size() && skyline[i].x < right)
+	{
+		int shrink = right - skyline[i].x;
+		if (shrink >= skyline[i].width)
+		{
+			skyline.erase(skyline.begin() + i);
+			continue;
+		}
+		skyline[i].x += shrink;
+		skyline[i].width -= shrink;
+		break;
+	}
+	// neighbours at the same height become one node
+	for (size_t j = 0; j + 1 < skyline.size();)
+	{
+		if (skyline[j].y == skyline[j + 1].y)
+		{
+			skyline[j].width += skyline[j + 1].width;
+			skyline.erase(skyline.begin() + j + 1);
+		}
+		else
+			j++;
+	}
+	return true;
+}
+
+bool SkylinePacker::PackAll(int width, int height, const std::vector<PackedRect>& sizes, std::vector<PackedRect>& rects)
+{
+	std::vector<size_t> order(sizes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a].height > sizes[b].height; });
+	SkylinePacker packer(width, height);
+	rects.assign(sizes.size(), PackedRect());
+	for (size_t index : order)
+	{
+		if (!packer.Insert(sizes[index].width, sizes[index].height, rects[index]))
+			return false;
+	}
+	return true;
+}
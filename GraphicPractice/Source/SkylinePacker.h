@@ -0,0 +1,41 @@
+#ifndef SKYLINE_PACKER_H
+#define SKYLINE_PACKER_H
+
+#include <cstddef>
+#include <vector>
+
+struct PackedRect
+{
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+// Rectangle packer that keeps the top edge of the placed rectangles as a
+// skyline and puts every new one where it ends lowest (bottom-left rule)
+class SkylinePacker
+{
+private:
+	struct Node
+	{
+		int x;
+		int y;
+		int width;
+	};
+	int width;
+	int height;
+	std::vector<Node> skyline;
+
+	// y the rectangle would rest at when its left edge is on node index, -1 if it does not fit
+	int FitAt(size_t index, int rectWidth, int rectHeight) const;
+public:
+	SkylinePacker(int width, int height);
+	void Reset();
+	// false when the rectangle fits nowhere
+	bool Insert(int rectWidth, int rectHeight, PackedRect& rect);
+	// packs every size, tallest first for a tighter skyline; rects come back in input order
+	static bool PackAll(int width, int height, const std::vector<PackedRect>& sizes, std::vector<PackedRect>& rects);
+};
+
+#endif
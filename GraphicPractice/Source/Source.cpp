@@ -1,5 +1,9 @@
+#include "AssetArchive.h"
 #include "Shader.h"
-#include "stb_image.h"
+#include "ShaderUniforms.h"
+#include "ShaderWatcher.h"
+#include "TextureLoader.h"
+#include "TextureResidency.h"
 #include <GLFW/glfw3.h>
 
 // structures
@@ -18,6 +22,7 @@ struct ShaderProgramSource
 // function declarations
 static bool GLLogCall(const char* function, const char* file, int line);
 static void GLClearError();
+static void BindUniforms(MainUniforms& uniforms, const Shader& shader);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 
@@ -58,6 +63,9 @@ int main()
         return -1;
     }
 
+    // packed assets (Tools/AssetPack), loose files are used when there is no archive
+    AssetArchive::Mount("Assets.pak");
+
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
     float vertices[] = {
@@ -97,45 +105,24 @@ int main()
     GLCall(glBindVertexArray(0));
 
     // Texture setup
-    unsigned int texture1;
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    // set the texture wrapping/filtering options (on the currently bound texture object)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // load and generate the texture
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load("container.jpg", &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        std::cout << "Failed to load texture" << std::endl;
-    }
-    stbi_image_free(data);
-
+    // files are read asynchronously (io_uring on Linux), decoded on worker threads
+    // and stream in through Update in the render loop
+    ThreadPool threadPool;
+    AsyncFileReader fileReader(threadPool);
+    TextureLoader textureLoader(threadPool, fileReader);
+    // textures are evicted or lose top mips to stay within this much GPU memory,
+    // and come back when they are drawn again
+    TextureResidency textureResidency(textureLoader, 256 * 1024 * 1024);
+    TextureOptions textureOptions;
+    textureOptions.minFilter = GL_LINEAR;
     // Flip for second image
-    stbi_set_flip_vertically_on_load(true);
-    // Texture setup
-    unsigned int texture2;
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-    // set the texture wrapping/filtering options (on the currently bound texture object)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    data = stbi_load("awesomeface.png", &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
+    TextureOptions flippedOptions = textureOptions;
+    flippedOptions.flipVertically = true;
+    std::vector<std::shared_ptr<Texture>> textures = textureLoader.Load({
+        { "container.jpg", textureOptions },
+        { "awesomeface.png", flippedOptions } });
+    std::shared_ptr<Texture> texture1 = textures[0];
+    std::shared_ptr<Texture> texture2 = textures[1];
 
     // wireframe polygons
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -149,8 +136,14 @@ int main()
     std::cout << "Maximum nr of vertex attributes supported: " << nrAttributes << std::endl;
 
     shader.use(); // don't forget to activate the shader before setting uniforms!  
-    glUniform1i(glGetUniformLocation(shader.GetID(), "texture1"), 0); // set it manually
-    shader.setInt("texture2", 1); // or with shader class
+    MainUniforms uniforms; // generated from the shaders by Tools/ShaderReflect
+    BindUniforms(uniforms, shader); // resolve once
+    uniforms.texture1.Set(shader, 0);
+    uniforms.texture2.Set(shader, 1);
+
+    // reload shader files when they are edited
+    ShaderWatcher shaderWatcher;
+    shaderWatcher.Watch(shader);
 
     // render loop
     // -----------
@@ -165,16 +158,28 @@ int main()
         glClear(GL_COLOR_BUFFER_BIT);
         glClearColor(0.5, 0.5, 0.5, 1);
 
+        // swap in edited shaders before binding
+        bool shaderReloaded = shaderWatcher.Update();
+
         // using shader for triangles
         GLCall(shader.use());
+        // uniforms start from defaults in a reloaded program
+        if (shaderReloaded)
+        {
+            BindUniforms(uniforms, shader);
+            uniforms.texture1.Set(shader, 0);
+            uniforms.texture2.Set(shader, 1);
+        }
 
         // draw rectangle with texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2);
+        textureLoader.Update();
+        textureResidency.Update();
+        texture1->Bind(0);
+        texture2->Bind(1);
 
         glBindVertexArray(VAO);
+        // send uniforms that changed since the last draw
+        shader.Flush();
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -214,6 +219,17 @@ static bool GLLogCall(const char* function, const char* file, int line)
     return true;
 }
 
+// uniforms: a name the program does not have means ShaderUniforms.h is out of date
+// ---------------------------------------------------------------------------------
+static void BindUniforms(MainUniforms& uniforms, const Shader& shader)
+{
+    if (uniforms.Bind(shader))
+        return;
+    for (const char* name : uniforms.Missing())
+        std::cout << "ERROR::SHADER::UNIFORM_NOT_FOUND " << name
+            << " (rebuild to run Tools/ShaderReflect again)" << std::endl;
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow* window)
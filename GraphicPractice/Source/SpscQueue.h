@@ -0,0 +1,49 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free ring for exactly one producer thread and one consumer thread.
+// Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+private:
+	static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+	T items[Capacity];
+	// written by the producer only
+	alignas(64) std::atomic<size_t> tail{ 0 };
+	// written by the consumer only
+	alignas(64) std::atomic<size_t> head{ 0 };
+public:
+	// producer: false if the queue is full
+	bool Push(const T& item)
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == Capacity)
+			return false;
+		items[t & (Capacity - 1)] = item;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+	// consumer: oldest item without removing it, nullptr if empty
+	T* Front()
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return nullptr;
+		return &items[h & (Capacity - 1)];
+	}
+	// consumer: removes the item returned by Front
+	void Pop()
+	{
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+	bool Empty() const
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "Texture.h"
+
+unsigned long long Texture::frame = 1;
+
+Texture::Texture(const std::string& path)
+	: path(path)
+{
+	glGenTextures(1, &ID);
+}
+
+Texture::~Texture()
+{
+	glDeleteTextures(1, &ID);
+}
+
+void Texture::Bind(unsigned int unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, ID);
+	lastBound = frame;
+}
+
+void Texture::SetParameters(GLenum wrap, GLenum minFilter, GLenum magFilter)
+{
+	this->wrap = wrap;
+	this->minFilter = minFilter;
+	this->magFilter = magFilter;
+	glBindTexture(GL_TEXTURE_2D, ID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+}
+
+void Texture::Replace(unsigned int id)
+{
+	glDeleteTextures(1, &ID);
+	ID = id;
+	if (!ID)
+		glGenTextures(1, &ID);
+	SetParameters(wrap, minFilter, magFilter);
+}
@@ -0,0 +1,64 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 2D texture object; the image arrives later when it is loaded through TextureLoader
+class Texture
+{
+private:
+	unsigned int ID = 0;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	bool ready = false;
+	std::string path;
+	GLenum wrap = GL_REPEAT;
+	GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+	GLenum magFilter = GL_LINEAR;
+	// storage as uploaded: format and the size of every level of the full chain
+	GLenum internalFormat = 0;
+	std::vector<size_t> levelSizes;
+	// levels allocated on the GPU and how many top levels TextureResidency left out,
+	// both 0 before the upload and after an eviction
+	int levelCount = 0;
+	int droppedLevels = 0;
+	size_t residentBytes = 0;
+	// frame of the last Bind, the frame counter is advanced by TextureResidency
+	mutable unsigned long long lastBound = 0;
+	static unsigned long long frame;
+	friend class TextureLoader;
+	friend class TextureResidency;
+
+	// replaces the GL object with id (a new one when 0) carrying the same parameters,
+	// immutable storage cannot be resized in place
+	void Replace(unsigned int id = 0);
+public:
+	// creates the GL object, render thread only
+	explicit Texture(const std::string& path = std::string());
+	~Texture();
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
+	unsigned int GetID() const { return ID; }
+	int GetWidth() const { return width; }
+	int GetHeight() const { return height; }
+	int GetChannels() const { return channels; }
+	const std::string& GetPath() const { return path; }
+	// false until the pixels were uploaded, and again after an eviction
+	bool IsReady() const { return ready; }
+	// GPU memory of the levels that are resident
+	size_t GetResidentBytes() const { return residentBytes; }
+	// top mips left out to fit the budget, the texture is that many times halved
+	int GetDroppedLevels() const { return droppedLevels; }
+	// binds to texture unit (GL_TEXTURE0 + unit)
+	void Bind(unsigned int unit) const;
+	// wrapping/filtering options
+	void SetParameters(GLenum wrap, GLenum minFilter, GLenum magFilter);
+};
+
+#endif
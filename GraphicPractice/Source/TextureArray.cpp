@@ -0,0 +1,97 @@
+#include "TextureArray.h"
+#include "PixelFormat.h"
+
+#include <algorithm>
+#include <iostream>
+
+
+TextureArray::TextureArray()
+{
+	glGenTextures(1, &ID);
+}
+
+TextureArray::~TextureArray()
+{
+	glDeleteTextures(1, &ID);
+}
+
+bool TextureArray::Build(const std::vector<const TextureImage*>& images, bool generateMipmaps)
+{
+	if (images.empty())
+		return false;
+	const TextureImage& first = *images[0];
+	size_t levelCount = first.levels.size();
+	for (const TextureImage* image : images)
+	{
+		if (image->width != first.width || image->height != first.height || image->channels != first.channels ||
+			image->bgra != first.bgra)
+		{
+			std::cout << "ERROR::TEXTURE_ARRAY::FORMAT_MISMATCH " << image->width << "x" << image->height
+				<< "x" << image->channels << std::endl;
+			return false;
+		}
+		levelCount = std::min(levelCount, image->levels.size());
+	}
+	// storage is immutable, a rebuild needs a fresh texture object (and its parameters set again)
+	if (layers > 0)
+	{
+		glDeleteTextures(1, &ID);
+		glGenTextures(1, &ID);
+	}
+	width = first.width;
+	height = first.height;
+	channels = first.channels;
+	layers = (int)images.size();
+	// a partial chain is not worth keeping, the driver builds a full one
+	bool ownMips = levelCount > 1 && first.levels.back().width == 1 && first.levels.back().height == 1 &&
+		levelCount == first.levels.size();
+	if (!ownMips)
+		levelCount = 1;
+
+	PixelFormat format = PixelFormats::ForImage(first);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+	GLsizei storageLevels = (GLsizei)levelCount;
+	if (!ownMips && generateMipmaps)
+	{
+		for (int size = std::max(width, height); size > 1; size /= 2)
+			storageLevels++;
+	}
+	// before 4.2 the levels are allocated one by one, MAX_LEVEL marks where the chain ends
+	if (GLAD_GL_VERSION_4_2)
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, storageLevels, format.internalFormat, width, height, layers);
+	else
+	{
+		for (GLsizei level = 0; level < storageLevels; level++)
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format.internalFormat, std::max(width >> level, 1),
+				std::max(height >> level, 1), layers, 0, format.format, format.type, NULL);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, storageLevels - 1);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (size_t level = 0; level < levelCount; level++)
+	{
+		const TextureLevel& size = first.levels[level];
+		for (int layer = 0; layer < layers; layer++)
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, 0, layer, size.width, size.height, 1,
+				format.format, format.type, images[layer]->GetLevelData(level));
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// only images loaded without a chain still need the driver
+	if (storageLevels > (GLsizei)levelCount)
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	return true;
+}
+
+void TextureArray::Bind(unsigned int unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+}
+
+void TextureArray::SetParameters(GLenum wrap, GLenum minFilter, GLenum magFilter)
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, magFilter);
+}
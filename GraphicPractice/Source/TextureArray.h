@@ -0,0 +1,38 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include "TextureImage.h"
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// GL_TEXTURE_2D_ARRAY with one layer per image, so materials that share a
+// size and channel count are bound once per pass and picked by layer index
+class TextureArray
+{
+private:
+	unsigned int ID = 0;
+	int width = 0;
+	int height = 0;
+	int layers = 0;
+	int channels = 0;
+public:
+	TextureArray();
+	~TextureArray();
+	TextureArray(const TextureArray&) = delete;
+	TextureArray& operator=(const TextureArray&) = delete;
+
+	// uploads every image as a layer in order; false if sizes or channel counts differ.
+	// mips come from the images when all of them have a full chain (TextureLoader builds one),
+	// otherwise from the driver
+	bool Build(const std::vector<const TextureImage*>& images, bool generateMipmaps = true);
+	void Bind(unsigned int unit) const;
+	void SetParameters(GLenum wrap, GLenum minFilter, GLenum magFilter);
+	unsigned int GetID() const { return ID; }
+	int GetWidth() const { return width; }
+	int GetHeight() const { return height; }
+	int GetLayerCount() const { return layers; }
+};
+
+#endif
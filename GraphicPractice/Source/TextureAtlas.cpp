@@ -0,0 +1,198 @@
+#include "TextureAtlas.h"
+#include "PixelFormat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+TextureAtlas::TextureAtlas()
+{
+	glGenTextures(1, &ID);
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	glDeleteTextures(1, &ID);
+}
+
+int TextureAtlas::GetMaxLevel(int width, int height, int padding)
+{
+	// level n filters blocks of 2^n texels; the padding has to cover a whole texel of
+	// the last level, and every level has to halve the atlas exactly
+	int maxLevel = 0;
+	while ((2 << maxLevel) <= padding && width % (2 << maxLevel) == 0 && height % (2 << maxLevel) == 0)
+		maxLevel++;
+	return maxLevel;
+}
+
+PackedRect TextureAtlas::GetPaddedSize(int imageWidth, int imageHeight, int granularity, int padding)
+{
+	// rounded up to whole blocks of the last level, the extra texels repeat the
+	// right and bottom edges like the rest of the border
+	PackedRect size;
+	size.width = (imageWidth + padding * 2 + granularity - 1) / granularity * granularity;
+	size.height = (imageHeight + padding * 2 + granularity - 1) / granularity * granularity;
+	return size;
+}
+
+bool TextureAtlas::Pack(const std::vector<PackedRect>& sizes, int width, int height, int padding, std::vector<PackedRect>& rects)
+{
+	// the skyline only ever starts a rect at 0 or at the edge of another one, so
+	// sizes in whole blocks keep every origin on a block and no block of any level
+	// mixes two images
+	int granularity = 1 << GetMaxLevel(width, height, padding);
+	std::vector<PackedRect> padded(sizes.size());
+	for (size_t i = 0; i < sizes.size(); i++)
+		padded[i] = GetPaddedSize(sizes[i].width, sizes[i].height, granularity, padding);
+	return SkylinePacker::PackAll(width, height, padded, rects);
+}
+
+bool TextureAtlas::Build(const std::vector<const TextureImage*>& images, int width, int height, int padding)
+{
+	std::vector<PackedRect> sizes(images.size());
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		sizes[i].width = images[i]->width;
+		sizes[i].height = images[i]->height;
+	}
+	std::vector<PackedRect> rects;
+	if (!Pack(sizes, width, height, padding, rects))
+	{
+		std::cout << "ERROR::TEXTURE_ATLAS::DOES_NOT_FIT " << width << "x" << height << std::endl;
+		return false;
+	}
+	return Build(images, width, height, padding, rects);
+}
+
+bool TextureAtlas::Build(const std::vector<const TextureImage*>& images, int width, int height, int padding,
+	const std::vector<PackedRect>& rects)
+{
+	if (images.empty() || rects.size() != images.size())
+		return false;
+	channels = images[0]->channels;
+	int maxLevel = GetMaxLevel(width, height, padding);
+	int granularity = 1 << maxLevel;
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		const PackedRect& rect = rects[i];
+		PackedRect size = GetPaddedSize(images[i]->width, images[i]->height, granularity, padding);
+		if (images[i]->channels != channels || images[i]->bgra != images[0]->bgra || rect.width != size.width ||
+			rect.height != size.height || rect.x < 0 || rect.y < 0 || rect.x % granularity != 0 ||
+			rect.y % granularity != 0 || rect.x + rect.width > width || rect.y + rect.height > height)
+		{
+			std::cout << "ERROR::TEXTURE_ATLAS::LAYOUT_MISMATCH " << i << std::endl;
+			return false;
+		}
+	}
+	this->width = width;
+	this->height = height;
+
+	// compose on the CPU, then a single upload
+	std::vector<unsigned char> pixels((size_t)width * height * channels, 0);
+	regions.assign(images.size(), AtlasRegion());
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		const TextureImage& image = *images[i];
+		const unsigned char* source = image.GetLevelData(0);
+		const PackedRect& rect = rects[i];
+		size_t pixelSize = channels;
+		for (int y = 0; y < rect.height; y++)
+		{
+			// the border repeats the nearest edge row/column
+			int sourceY = std::min(std::max(y - padding, 0), image.height - 1);
+			const unsigned char* sourceRow = source + (size_t)sourceY * image.width * pixelSize;
+			unsigned char* row = pixels.data() + ((size_t)(rect.y + y) * width + rect.x) * pixelSize;
+			for (int x = 0; x < padding; x++)
+				memcpy(row + x * pixelSize, sourceRow, pixelSize);
+			for (int x = padding + image.width; x < rect.width; x++)
+				memcpy(row + x * pixelSize, sourceRow + (image.width - 1) * pixelSize, pixelSize);
+			memcpy(row + padding * pixelSize, sourceRow, image.width * pixelSize);
+		}
+
+		AtlasRegion& region = regions[i];
+		region.rect.x = rect.x + padding;
+		region.rect.y = rect.y + padding;
+		region.rect.width = image.width;
+		region.rect.height = image.height;
+		region.uvScale[0] = (float)image.width / width;
+		region.uvScale[1] = (float)image.height / height;
+		region.uvOffset[0] = (float)region.rect.x / width;
+		region.uvOffset[1] = (float)region.rect.y / height;
+	}
+
+	// storage is immutable, a rebuild needs a fresh texture object
+	if (uploaded)
+	{
+		glDeleteTextures(1, &ID);
+		glGenTextures(1, &ID);
+	}
+	uploaded = true;
+	PixelFormat format = PixelFormats::ForImage(*images[0]);
+	glBindTexture(GL_TEXTURE_2D, ID);
+	// mips past log2(padding) levels blend neighbours, so the chain stops there
+	if (GLAD_GL_VERSION_4_2)
+	{
+		glTexStorage2D(GL_TEXTURE_2D, maxLevel + 1, format.internalFormat, width, height);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format.format, format.type, pixels.data());
+	}
+	else
+	{
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, format.internalFormat, width, height, 0, format.format, format.type, pixels.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, maxLevel > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (maxLevel > 0)
+		glGenerateMipmap(GL_TEXTURE_2D);
+	return true;
+}
+
+void TextureAtlas::Bind(unsigned int unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, ID);
+}
+
+bool TextureAtlas::SaveLayout(const std::string& path, int width, int height, int padding,
+	const std::vector<std::string>& names, const std::vector<PackedRect>& rects)
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "ERROR::TEXTURE_ATLAS::CANNOT_WRITE " << path << std::endl;
+		return false;
+	}
+	file << "atlas " << width << " " << height << " " << padding << "\n";
+	for (size_t i = 0; i < rects.size(); i++)
+		file << rects[i].x << " " << rects[i].y << " " << rects[i].width << " " << rects[i].height << " " << names[i] << "\n";
+	return (bool)file;
+}
+
+bool TextureAtlas::LoadLayout(const std::string& path, int& width, int& height, int& padding,
+	std::vector<std::string>& names, std::vector<PackedRect>& rects)
+{
+	std::ifstream file(path);
+	std::string tag;
+	if (!(file >> tag >> width >> height >> padding) || tag != "atlas")
+	{
+		std::cout << "ERROR::TEXTURE_ATLAS::INVALID_LAYOUT " << path << std::endl;
+		return false;
+	}
+	names.clear();
+	rects.clear();
+	PackedRect rect;
+	std::string name;
+	// names run to the end of the line, so they may contain spaces
+	while (file >> rect.x >> rect.y >> rect.width >> rect.height && std::getline(file >> std::ws, name))
+	{
+		rects.push_back(rect);
+		names.push_back(name);
+	}
+	return true;
+}
@@ -0,0 +1,64 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "SkylinePacker.h"
+#include "TextureImage.h"
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+// where an image ended up, uv = uv * scale + offset maps its 0..1 coordinates into the atlas
+struct AtlasRegion
+{
+	PackedRect rect;
+	float uvScale[2] = { 1.0f, 1.0f };
+	float uvOffset[2] = { 0.0f, 0.0f };
+};
+
+// Packs images with the same channel count into one 2D texture so a pass
+// binds it once. Each image keeps a border of repeated edge pixels so
+// filtering never pulls in a neighbour; the mip chain stops at the level the
+// border still covers and rects sit on that level's texel grid.
+class TextureAtlas
+{
+private:
+	unsigned int ID = 0;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	// storage is allocated, a rebuild needs a new texture object
+	bool uploaded = false;
+	std::vector<AtlasRegion> regions;
+
+	// the last mip level that never blends two images
+	static int GetMaxLevel(int width, int height, int padding);
+	// an image's rect with its border, in whole texels of the last mip level
+	static PackedRect GetPaddedSize(int imageWidth, int imageHeight, int granularity, int padding);
+public:
+	TextureAtlas();
+	~TextureAtlas();
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	// packs at runtime, false if the images do not fit or their channel counts differ
+	bool Build(const std::vector<const TextureImage*>& images, int width, int height, int padding = 2);
+	// places the images at rects packed offline (Tools/AtlasPack), padding included in the rects
+	bool Build(const std::vector<const TextureImage*>& images, int width, int height, int padding,
+		const std::vector<PackedRect>& rects);
+	void Bind(unsigned int unit) const;
+	unsigned int GetID() const { return ID; }
+	const AtlasRegion& GetRegion(size_t index) const { return regions[index]; }
+	size_t GetRegionCount() const { return regions.size(); }
+
+	// padded rects for images of the given sizes, aligned for the atlas' mip chain
+	static bool Pack(const std::vector<PackedRect>& sizes, int width, int height, int padding, std::vector<PackedRect>& rects);
+	// text file: "atlas <width> <height> <padding>" then "<x> <y> <width> <height> <name>" per image
+	static bool SaveLayout(const std::string& path, int width, int height, int padding,
+		const std::vector<std::string>& names, const std::vector<PackedRect>& rects);
+	static bool LoadLayout(const std::string& path, int& width, int& height, int& padding,
+		std::vector<std::string>& names, std::vector<PackedRect>& rects);
+};
+
+#endif
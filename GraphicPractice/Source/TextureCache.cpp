@@ -0,0 +1,255 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <vector>
+
+std::string TextureCache::directory = "TextureCache";
+uint64_t TextureCache::sizeLimit = 512ull * 1024 * 1024;
+
+// file layout: header (magic, width, height, channels, level count, flags, level table) padded to a
+// page, then every level starting on a page boundary so it can be mapped and uploaded as is
+static const char cacheMagic[4] = { 'G', 'P', 'T', '2' };
+static const size_t pageSize = 4096;
+static const uint32_t maxLevels = 32;
+
+struct CacheLevel
+{
+	uint32_t width;
+	uint32_t height;
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct CacheHeader
+{
+	char magic[4];
+	uint32_t width;
+	uint32_t height;
+	uint32_t channels;
+	uint32_t levelCount;
+	// bit 0: BGRA channel order
+	uint32_t flags;
+	CacheLevel levels[maxLevels];
+};
+
+static_assert(sizeof(CacheHeader) <= pageSize, "texture cache header must fit in a page");
+
+// bytes in the directory as of the last sweep plus everything stored since,
+// the directory is only scanned again once this passes the size limit
+static std::mutex sweepMutex;
+static uint64_t storedBytes = 0;
+static bool storedBytesKnown = false;
+
+static size_t AlignToPage(size_t offset)
+{
+	return (offset + pageSize - 1) & ~(pageSize - 1);
+}
+
+// 64 bit FNV-1a
+static void HashBytes(uint64_t& hash, const char* data, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+// a temporary file of its own for every store: loader threads can store the same
+// key at once, and so can two processes sharing the directory
+static std::string TempPathFor(const std::string& path)
+{
+	static const unsigned int processTag = std::random_device()();
+	static std::atomic<unsigned int> counter(0);
+	return path + "." + std::to_string(processTag) + "." + std::to_string(counter++) + ".tmp";
+}
+
+void TextureCache::SetDirectory(const std::string& path)
+{
+	directory = path;
+	std::lock_guard<std::mutex> lock(sweepMutex);
+	storedBytesKnown = false;
+}
+
+void TextureCache::SetSizeLimit(uint64_t bytes)
+{
+	sizeLimit = bytes;
+}
+
+std::string TextureCache::PathFor(const std::string& key)
+{
+	return directory + "/" + key + ".tex";
+}
+
+std::string TextureCache::MakeKey(std::string_view source, std::string_view variant)
+{
+	uint64_t hash = 14695981039346656037ull;
+	HashBytes(hash, source.data(), source.size());
+	HashBytes(hash, "\0", 1);
+	HashBytes(hash, variant.data(), variant.size());
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+	return key;
+}
+
+bool TextureCache::Load(const std::string& key, TextureImage& image)
+{
+	std::string path = PathFor(key);
+	MappedFile file;
+	if (!file.Open(path) || file.GetSize() < pageSize)
+		return false;
+	CacheHeader header;
+	memcpy(&header, file.GetData(), sizeof(header));
+	if (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.levelCount == 0 ||
+		header.levelCount > maxLevels || header.channels < 1 || header.channels > 4)
+		return false;
+
+	image.levels.clear();
+	for (uint32_t i = 0; i < header.levelCount; i++)
+	{
+		const CacheLevel& cached = header.levels[i];
+		// a truncated file is as good as a missing one
+		if (cached.offset > file.GetSize() || cached.size > file.GetSize() - cached.offset ||
+			cached.size != (uint64_t)cached.width * cached.height * header.channels)
+		{
+			image.levels.clear();
+			return false;
+		}
+		TextureLevel level;
+		level.width = cached.width;
+		level.height = cached.height;
+		level.offset = (size_t)cached.offset;
+		level.size = (size_t)cached.size;
+		image.levels.push_back(level);
+	}
+	image.width = header.width;
+	image.height = header.height;
+	image.channels = header.channels;
+	image.bgra = (header.flags & 1) != 0;
+	image.storage.clear();
+	image.file = std::move(file);
+
+	// the write time doubles as the last use for eviction
+	std::error_code error;
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+	return true;
+}
+
+bool TextureCache::Store(const std::string& key, const TextureImage& image)
+{
+	if (image.levels.empty() || image.levels.size() > maxLevels)
+		return false;
+	CacheHeader header = {};
+	memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.width = image.width;
+	header.height = image.height;
+	header.channels = image.channels;
+	header.levelCount = (uint32_t)image.levels.size();
+	header.flags = image.bgra ? 1 : 0;
+	size_t offset = pageSize;
+	for (size_t i = 0; i < image.levels.size(); i++)
+	{
+		header.levels[i].width = image.levels[i].width;
+		header.levels[i].height = image.levels[i].height;
+		header.levels[i].offset = offset;
+		header.levels[i].size = image.levels[i].size;
+		offset = AlignToPage(offset + image.levels[i].size);
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	// write to a temporary file first so a crash never leaves half an image behind
+	std::string path = PathFor(key);
+	std::string tempPath = TempPathFor(path);
+	bool written;
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::TEXTURE_CACHE::CANNOT_WRITE " << tempPath << std::endl;
+			return false;
+		}
+		static const char padding[pageSize] = {};
+		file.write((const char*)&header, sizeof(header));
+		file.write(padding, pageSize - sizeof(header));
+		for (size_t i = 0; i < image.levels.size(); i++)
+		{
+			file.write((const char*)image.GetLevelData(i), image.levels[i].size);
+			size_t end = header.levels[i].offset + image.levels[i].size;
+			file.write(padding, AlignToPage(end) - end);
+		}
+		written = (bool)file;
+	}
+	// a short write (disk full) leaves nothing behind either
+	if (written)
+		std::filesystem::rename(tempPath, path, error);
+	if (!written || error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	bool sweep;
+	{
+		std::lock_guard<std::mutex> lock(sweepMutex);
+		storedBytes += offset;
+		sweep = !storedBytesKnown || storedBytes > sizeLimit;
+	}
+	if (sweep)
+		Evict();
+	return true;
+}
+
+void TextureCache::Evict()
+{
+	struct CacheFile
+	{
+		std::filesystem::path path;
+		uint64_t size;
+		std::filesystem::file_time_type lastUse;
+	};
+	// stores from several loader threads would otherwise race to delete the same files
+	std::lock_guard<std::mutex> lock(sweepMutex);
+
+	std::error_code error;
+	std::vector<CacheFile> files;
+	uint64_t total = 0;
+	for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+	{
+		if (it->path().extension() != ".tex")
+			continue;
+		CacheFile file;
+		file.path = it->path();
+		file.size = it->file_size(error);
+		file.lastUse = it->last_write_time(error);
+		if (error)
+		{
+			error.clear();
+			continue;
+		}
+		total += file.size;
+		files.push_back(file);
+	}
+	if (total > sizeLimit)
+	{
+		std::sort(files.begin(), files.end(),
+			[](const CacheFile& a, const CacheFile& b) { return a.lastUse < b.lastUse; });
+		for (const CacheFile& file : files)
+		{
+			if (total <= sizeLimit)
+				break;
+			// files still mapped elsewhere may refuse, they go on a later pass
+			if (std::filesystem::remove(file.path, error))
+				total -= file.size;
+		}
+	}
+	storedBytes = total;
+	storedBytesKnown = true;
+}
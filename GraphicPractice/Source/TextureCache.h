@@ -0,0 +1,35 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "TextureImage.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Stores decoded textures with their mip chain on disk so warm starts skip
+// decoding; files are raw and page aligned so a hit is just a mapping
+class TextureCache
+{
+private:
+	static std::string directory;
+	static uint64_t sizeLimit;
+	// path of the cache file for a key
+	static std::string PathFor(const std::string& key);
+	// removes least recently used files until the directory fits the size limit
+	static void Evict();
+public:
+	// directory for cache files, created on first store
+	static void SetDirectory(const std::string& path);
+	// total bytes the directory may grow to
+	static void SetSizeLimit(uint64_t bytes);
+	// key from the encoded file contents and a description of everything else that
+	// changes the decoded pixels (flip, mip filter, color space)
+	static std::string MakeKey(std::string_view source, std::string_view variant);
+	// maps the cached image, false if missing or invalid
+	static bool Load(const std::string& key, TextureImage& image);
+	// writes the image and all of its levels
+	static bool Store(const std::string& key, const TextureImage& image);
+};
+
+#endif
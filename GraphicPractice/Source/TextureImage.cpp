@@ -0,0 +1,48 @@
+#include "TextureImage.h"
+
+#include <cstring>
+
+void TextureImage::Assign(const unsigned char* pixels, int width, int height, int channels)
+{
+	unsigned char* level = Allocate(width, height, channels);
+	memcpy(level, pixels, levels[0].size);
+}
+
+unsigned char* TextureImage::Allocate(int width, int height, int channels)
+{
+	this->width = width;
+	this->height = height;
+	this->channels = channels;
+	bgra = false;
+	compressedFormat = 0;
+	file.Close();
+	TextureLevel level;
+	level.width = width;
+	level.height = height;
+	level.size = (size_t)width * height * channels;
+	levels.assign(1, level);
+	// what MipGenerator::Build asks for, so building the chain never moves level 0
+	storage.clear();
+	storage.reserve(level.size + level.size / 3 + 16 * channels);
+	storage.resize(level.size);
+	return storage.data();
+}
+
+void TextureImage::BuildMips(MipFilter filter, bool srgb)
+{
+	MipGenerator::Build(*this, filter, srgb);
+}
+
+const unsigned char* TextureImage::GetLevelData(size_t level) const
+{
+	const unsigned char* base = file.IsOpen() ? (const unsigned char*)file.GetData() : storage.data();
+	return base + levels[level].offset;
+}
+
+size_t TextureImage::GetTotalSize() const
+{
+	size_t total = 0;
+	for (const TextureLevel& level : levels)
+		total += level.size;
+	return total;
+}
@@ -0,0 +1,77 @@
+#ifndef TEXTURE_IMAGE_H
+#define TEXTURE_IMAGE_H
+
+#include "MappedFile.h"
+#include "MipGenerator.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Leaves resized elements uninitialized: every byte of pixel storage is written
+// by the decoder or the mip builder anyway, and zero filling first would touch
+// all pages of an image before the decode has even checked its data
+template <typename T>
+struct UninitializedAllocator : std::allocator<T>
+{
+	template <typename U>
+	struct rebind
+	{
+		typedef UninitializedAllocator<U> other;
+	};
+
+	UninitializedAllocator() = default;
+	template <typename U>
+	UninitializedAllocator(const UninitializedAllocator<U>&) {}
+
+	template <typename U>
+	void construct(U* pointer)
+	{
+		::new ((void*)pointer) U;
+	}
+	template <typename U, typename... Args>
+	void construct(U* pointer, Args&&... args)
+	{
+		::new ((void*)pointer) U(std::forward<Args>(args)...);
+	}
+};
+
+typedef std::vector<unsigned char, UninitializedAllocator<unsigned char>> PixelStorage;
+
+struct TextureLevel
+{
+	int width = 0;
+	int height = 0;
+	// from the start of the image data
+	size_t offset = 0;
+	size_t size = 0;
+};
+
+// Decoded pixels of a texture and its mip chain with tightly packed rows,
+// held either in owned storage or in a mapped cache file
+struct TextureImage
+{
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	// 4 channel images stored as BGRA (see PixelFormats)
+	bool bgra = false;
+	// GL format of block compressed levels (see KtxFile), 0 for plain pixels
+	unsigned int compressedFormat = 0;
+	std::vector<TextureLevel> levels;
+	PixelStorage storage;
+	MappedFile file;
+
+	// copies level 0, drops any mips
+	void Assign(const unsigned char* pixels, int width, int height, int channels);
+	// level 0 to be written in place, storage already has room for a mip chain
+	unsigned char* Allocate(int width, int height, int channels);
+	// replaces the levels below 0 with a chain down to 1x1 (see MipGenerator)
+	void BuildMips(MipFilter filter = MipFilter::Kaiser, bool srgb = true);
+	const unsigned char* GetLevelData(size_t level) const;
+	// bytes of all levels
+	size_t GetTotalSize() const;
+};
+
+#endif
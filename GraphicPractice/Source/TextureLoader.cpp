@@ -0,0 +1,341 @@
+#include "TextureLoader.h"
+#include "AssetArchive.h"
+#include "AssetFile.h"
+#include "BcnEncoder.h"
+#include "DecodeArena.h"
+#include "KtxFile.h"
+#include "PixelFormat.h"
+#include "PixelKernels.h"
+#include "TextureCache.h"
+#include "TextureResidency.h"
+#include "stb_image.h"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// decodes submitted by every loader and not finished yet; the arenas belong to
+// the pool's threads, not to a loader, so they go once none is left anywhere
+static std::atomic<int> pendingDecodes(0);
+
+static void ReleaseArenaWhenDone()
+{
+	if (pendingDecodes == 0)
+		DecodeArena::Release();
+}
+
+static bool HasExtension(const char* extension)
+{
+	int count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (int i = 0; i < count; i++)
+	{
+		const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (name && strcmp(name, extension) == 0)
+			return true;
+	}
+	return false;
+}
+
+// the formats KtxFile produces: RGTC is core since 3.0, BPTC since 4.2 and S3TC is
+// only ever an extension (its sRGB forms come with it on desktop drivers)
+static bool IsCompressedFormatSupported(GLenum format)
+{
+	static const bool s3tc = HasExtension("GL_EXT_texture_compression_s3tc");
+	static const bool bptc = GLAD_GL_VERSION_4_2 || HasExtension("GL_ARB_texture_compression_bptc");
+	switch (format)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		return s3tc;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		return bptc;
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_RG_RGTC2:
+		return true;
+	}
+	return false;
+}
+
+TextureLoader::TextureLoader(ThreadPool& pool, AsyncFileReader& reader)
+	: pool(pool), reader(reader)
+{
+	glGenBuffers(pboCount, pbos);
+	// decode threads convert to whatever the driver copies fastest
+	PixelFormats::QueryDriverPreferences();
+	// the arenas are only worth keeping while a load is running
+	pool.SetIdleTask(ReleaseArenaWhenDone);
+}
+
+TextureLoader::~TextureLoader()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	decodesDone.wait(lock, [this]() { return decoding == 0; });
+	glDeleteBuffers(pboCount, pbos);
+}
+
+std::shared_ptr<Texture> TextureLoader::Load(const std::string& path, const TextureOptions& options)
+{
+	return Load(std::vector<TextureRequest>{ { path, options } })[0];
+}
+
+std::vector<std::shared_ptr<Texture>> TextureLoader::Load(const std::vector<TextureRequest>& manifest)
+{
+	std::vector<std::shared_ptr<Texture>> textures;
+	std::vector<DecodedImage> images;
+	for (const TextureRequest& request : manifest)
+	{
+		DecodedImage image;
+		image.texture = std::make_shared<Texture>(request.path);
+		image.texture->SetParameters(request.options.wrap, request.options.minFilter, request.options.magFilter);
+		image.options = request.options;
+		textures.push_back(image.texture);
+		images.push_back(image);
+		if (residency)
+			residency->Track(image.texture, request.options);
+	}
+	Submit(images);
+	return textures;
+}
+
+void TextureLoader::Reload(const std::shared_ptr<Texture>& texture, const TextureOptions& options)
+{
+	DecodedImage image;
+	image.texture = texture;
+	image.options = options;
+	Submit(std::vector<DecodedImage>{ image });
+}
+
+void TextureLoader::Submit(const std::vector<DecodedImage>& images)
+{
+	// every image waiting on a path, one read serves them all
+	auto waiting = std::make_shared<std::unordered_map<std::string, std::vector<DecodedImage>>>();
+	std::vector<std::string> paths;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		decoding += (int)images.size();
+	}
+	pendingDecodes += (int)images.size();
+	for (const DecodedImage& image : images)
+	{
+		const std::string& path = image.texture->GetPath();
+		// archived files are mapped already, they only need a decode
+		if (AssetArchive::ContainsMounted(path))
+		{
+			pool.Submit([this, image]()
+			{
+				AssetFile file(image.texture->GetPath());
+				Decode(image, file.GetView(), file.IsOpen());
+			});
+		}
+		else
+		{
+			std::vector<DecodedImage>& waitingImages = (*waiting)[path];
+			if (waitingImages.empty())
+				paths.push_back(path);
+			waitingImages.push_back(image);
+		}
+	}
+	// the map is complete before any read finishes and only read from then on
+	reader.Read(paths, [this, waiting](FileRead& read)
+	{
+		for (const DecodedImage& image : waiting->at(read.path))
+			Decode(image, std::string_view(read.data.data(), read.data.size()), read.success);
+	});
+}
+
+void TextureLoader::Decode(DecodedImage image, std::string_view source, bool found)
+{
+	const std::string& path = image.texture->GetPath();
+	std::string key;
+	image.image = std::make_shared<TextureImage>();
+	// block compressed files are uploaded as they are, there is nothing to decode or cache
+	bool compressed = found && KtxFile::IsKtx2(source);
+	if (compressed)
+	{
+		if (!KtxFile::Parse(source, *image.image))
+			std::cout << "Failed to load texture " << path << ": unsupported KTX2 file" << std::endl;
+	}
+	else if (found && image.options.useCache)
+	{
+		const TextureOptions& options = image.options;
+		std::string variant = std::string("flip=") + (options.flipVertically ? "1" : "0") +
+			" mips=" + (!options.generateMipmaps ? "none" : options.mipFilter == MipFilter::Box ? "box" : "kaiser") +
+			" srgb=" + (options.srgb ? "1" : "0") + " " + PixelFormats::Variant(options.premultiplyAlpha);
+		key = TextureCache::MakeKey(source, variant);
+	}
+	// a cache hit skips stb_image entirely, the levels point into the mapped file
+	bool cached = !key.empty() && TextureCache::Load(key, *image.image);
+	if (!cached && !compressed && found)
+	{
+		int width = 0, height = 0, channels = 0;
+		bool decodedPixels = false;
+		{
+			// stb_image's temporaries live in this thread's arena until the scope ends, and
+			// with the size from the header it decodes straight into the image's storage
+			DecodeArena::Scope scope;
+			unsigned char* staging = nullptr;
+			if (stbi_info_from_memory((const stbi_uc*)source.data(), (int)source.size(), &width, &height, &channels))
+			{
+				scope.SetOutput((size_t)width * height * channels, [&]()
+				{
+					return staging = image.image->Allocate(width, height, channels);
+				});
+			}
+			unsigned char* pixels = stbi_load_from_memory((const stbi_uc*)source.data(), (int)source.size(),
+				&width, &height, &channels, 0);
+			decodedPixels = pixels != nullptr;
+			// the output went elsewhere (a converted or differently sized decode), it is copied
+			if (pixels && pixels != staging)
+				image.image->Assign(pixels, width, height, channels);
+		}
+		if (decodedPixels)
+		{
+			// flipped on the copy, stb_image's own flip would need per thread state and another pass
+			if (image.options.flipVertically)
+				PixelKernels::FlipRows(image.image->storage.data(), (size_t)width * channels, height);
+			// layout conversion first, so the mips are built in the uploaded layout
+			PixelFormats::Convert(*image.image, image.options.premultiplyAlpha);
+			if (image.options.generateMipmaps)
+				image.image->BuildMips(image.options.mipFilter, image.options.srgb);
+			if (!key.empty())
+				TextureCache::Store(key, *image.image);
+		}
+		else
+		{
+			image.image->levels.clear();
+			image.image->storage.clear();
+			std::cout << "Failed to load texture " << path << ": " << stbi_failure_reason() << std::endl;
+		}
+	}
+	else if (!found)
+		std::cout << "Failed to load texture " << path << ": cannot open file" << std::endl;
+
+	pendingDecodes--;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!image.image->levels.empty())
+		decoded.push_back(image);
+	decoding--;
+	decodesDone.notify_all();
+}
+
+void TextureLoader::Upload(DecodedImage& decodedImage)
+{
+	const TextureImage& image = *decodedImage.image;
+	Texture& texture = *decodedImage.texture;
+	PixelFormat format = PixelFormats::ForImage(image);
+	size_t size = image.GetTotalSize();
+	// a driver without the format leaves the texture not ready
+	if (image.compressedFormat)
+	{
+		if (!IsCompressedFormatSupported(image.compressedFormat))
+		{
+			std::cout << "ERROR::TEXTURE::COMPRESSED_FORMAT_NOT_SUPPORTED " << texture.GetPath() << std::endl;
+			decodedImage.image.reset();
+			return;
+		}
+	}
+
+	// orphaning the buffer means the map never waits for an earlier upload to finish
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[nextPbo]);
+	nextPbo = (nextPbo + 1) % pboCount;
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+	unsigned char* dst = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	// offsets of every level inside the PBO, they are packed back to back
+	std::vector<size_t> offsets(image.levels.size());
+	bool fromBuffer = dst != nullptr;
+	if (dst)
+	{
+		size_t offset = 0;
+		for (size_t i = 0; i < image.levels.size(); i++)
+		{
+			memcpy(dst + offset, image.GetLevelData(i), image.levels[i].size);
+			offsets[i] = offset;
+			offset += image.levels[i].size;
+		}
+		fromBuffer = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+	}
+	if (!fromBuffer)
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// a reloaded texture gets a new object, its storage is immutable
+	if (texture.levelCount)
+		texture.Replace();
+	glBindTexture(GL_TEXTURE_2D, texture.ID);
+	// rows of RGB images are not 4 byte aligned in general
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	// immutable storage for exactly the levels we have, the chain was built on the CPU;
+	// before 4.2 every level is specified on its own and MAX_LEVEL keeps a short chain complete
+	GLenum internalFormat = image.compressedFormat ? image.compressedFormat : format.internalFormat;
+	bool immutable = GLAD_GL_VERSION_4_2 != 0;
+	if (immutable)
+		glTexStorage2D(GL_TEXTURE_2D, (GLsizei)image.levels.size(), internalFormat, image.width, image.height);
+	else
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+	// from the PBO the driver copies asynchronously, otherwise straight from client memory
+	for (size_t i = 0; i < image.levels.size(); i++)
+	{
+		const TextureLevel& level = image.levels[i];
+		const void* source = fromBuffer ? (const void*)offsets[i] : image.GetLevelData(i);
+		if (image.compressedFormat && immutable)
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)i, 0, 0, level.width, level.height,
+				image.compressedFormat, (GLsizei)level.size, source);
+		else if (image.compressedFormat)
+			glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, image.compressedFormat, level.width, level.height, 0,
+				(GLsizei)level.size, source);
+		else if (immutable)
+			glTexSubImage2D(GL_TEXTURE_2D, (GLint)i, 0, 0, level.width, level.height, format.format, format.type, source);
+		else
+			glTexImage2D(GL_TEXTURE_2D, (GLint)i, internalFormat, level.width, level.height, 0, format.format, format.type, source);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	texture.width = image.width;
+	texture.height = image.height;
+	texture.channels = image.channels;
+	texture.internalFormat = internalFormat;
+	texture.levelSizes.clear();
+	for (const TextureLevel& level : image.levels)
+		texture.levelSizes.push_back(level.size);
+	texture.levelCount = (int)image.levels.size();
+	texture.droppedLevels = 0;
+	texture.residentBytes = size;
+	texture.ready = true;
+	// a fresh upload counts as bound this frame, otherwise TextureResidency would
+	// evict it as least recently used before anything had a chance to draw it
+	texture.lastBound = Texture::frame;
+	// frees the pixels or unmaps the cache file
+	decodedImage.image.reset();
+}
+
+int TextureLoader::Update(size_t budgetBytes)
+{
+	int uploaded = 0;
+	size_t bytes = 0;
+	while (bytes < budgetBytes)
+	{
+		DecodedImage image;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (decoded.empty())
+				break;
+			image = decoded.front();
+			decoded.pop_front();
+		}
+		bytes += image.image->GetTotalSize();
+		Upload(image);
+		uploaded++;
+	}
+	return uploaded;
+}
+
+bool TextureLoader::IsIdle()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return decoding == 0 && decoded.empty();
+}
@@ -0,0 +1,95 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include "AsyncFileReader.h"
+#include "Texture.h"
+#include "TextureImage.h"
+#include "ThreadPool.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+class TextureResidency;
+
+struct TextureOptions
+{
+	bool flipVertically = false;
+	// the chain is built on the loader threads and cached, never by the driver
+	bool generateMipmaps = true;
+	MipFilter mipFilter = MipFilter::Kaiser;
+	// color channels hold sRGB encoded values, mips are filtered in linear light
+	bool srgb = true;
+	bool premultiplyAlpha = false;
+	// keep the decoded pixels in TextureCache for later runs
+	bool useCache = true;
+	GLenum wrap = GL_REPEAT;
+	GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+	GLenum magFilter = GL_LINEAR;
+};
+
+struct TextureRequest
+{
+	std::string path;
+	TextureOptions options;
+};
+
+// Reads images through AsyncFileReader, decodes them on a thread pool and
+// uploads them from the render thread through a ring of pixel buffer objects,
+// so neither disk nor decode ever stalls a frame. Decoded images and their
+// mips go through TextureCache. KTX2 files with BCn blocks skip both and are
+// uploaded compressed.
+class TextureLoader
+{
+private:
+	struct DecodedImage
+	{
+		std::shared_ptr<Texture> texture;
+		TextureOptions options;
+		std::shared_ptr<TextureImage> image;
+	};
+
+	static const int pboCount = 3;
+	ThreadPool& pool;
+	AsyncFileReader& reader;
+	unsigned int pbos[pboCount] = {};
+	int nextPbo = 0;
+	std::mutex mutex;
+	std::condition_variable decodesDone;
+	std::deque<DecodedImage> decoded;
+	// decodes submitted but not finished
+	int decoding = 0;
+	// set while a TextureResidency manages this loader's textures
+	TextureResidency* residency = nullptr;
+	friend class TextureResidency;
+
+	// reads and decodes the images, textures whose files are shared are read once
+	void Submit(const std::vector<DecodedImage>& images);
+	// source is empty when the file could not be read
+	void Decode(DecodedImage image, std::string_view source, bool found);
+	void Upload(DecodedImage& image);
+public:
+	TextureLoader(ThreadPool& pool, AsyncFileReader& reader);
+	// waits for decodes still running
+	~TextureLoader();
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	// returns the texture right away, it becomes ready after a later Update
+	std::shared_ptr<Texture> Load(const std::string& path, const TextureOptions& options = TextureOptions());
+	// reads of the whole manifest are submitted as one batch, textures come back in manifest order
+	std::vector<std::shared_ptr<Texture>> Load(const std::vector<TextureRequest>& manifest);
+	// loads the file again into an existing texture, which keeps what it has until the
+	// new upload replaces it (evicted or reduced textures, see TextureResidency)
+	void Reload(const std::shared_ptr<Texture>& texture, const TextureOptions& options);
+	// render thread: uploads decoded images, stops after budgetBytes (at least one image),
+	// returns how many textures became ready
+	int Update(size_t budgetBytes = 16 * 1024 * 1024);
+	// nothing is decoding or waiting for upload
+	bool IsIdle();
+};
+
+#endif
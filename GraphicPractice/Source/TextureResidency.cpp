@@ -0,0 +1,234 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+
+TextureResidency::TextureResidency(TextureLoader& loader, size_t budgetBytes)
+	: loader(loader), budget(budgetBytes)
+{
+	loader.residency = this;
+}
+
+TextureResidency::~TextureResidency()
+{
+	loader.residency = nullptr;
+}
+
+void TextureResidency::Track(const std::shared_ptr<Texture>& texture, const TextureOptions& options)
+{
+	Entry entry;
+	entry.texture = texture;
+	entry.options = options;
+	entries.push_back(entry);
+}
+
+size_t TextureResidency::GetFullSize(const Texture& texture)
+{
+	size_t size = 0;
+	for (size_t levelSize : texture.levelSizes)
+		size += levelSize;
+	return size;
+}
+
+bool TextureResidency::IsInUse(const Texture& texture) const
+{
+	// Update advanced the frame, so a texture bound last frame is one behind
+	return texture.lastBound + 1 >= Texture::frame;
+}
+
+void TextureResidency::Evict(Entry& entry, Texture& texture)
+{
+	// dropping the object frees the storage, the new one stays incomplete until a reload
+	texture.Replace();
+	texture.ready = false;
+	texture.levelCount = 0;
+	texture.droppedLevels = 0;
+	texture.residentBytes = 0;
+	entry.evicted = true;
+}
+
+void TextureResidency::CopyThroughBuffer(const Texture& texture, unsigned int id, int levels, int width, int height)
+{
+	// plain textures are one of the PixelFormats layouts, anything else is block compressed
+	GLenum format = 0;
+	switch (texture.internalFormat)
+	{
+	case GL_R8: format = GL_RED; break;
+	case GL_RG8: format = GL_RG; break;
+	case GL_RGB8: format = GL_RGB; break;
+	case GL_RGBA8: format = GL_RGBA; break;
+	}
+	std::vector<size_t> offsets(levels);
+	size_t total = 0;
+	for (int i = 0; i < levels; i++)
+	{
+		offsets[i] = total;
+		total += texture.levelSizes[texture.droppedLevels + 1 + i];
+	}
+	unsigned int buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, total, NULL, GL_STREAM_COPY);
+	glBindTexture(GL_TEXTURE_2D, texture.ID);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	for (int i = 0; i < levels; i++)
+	{
+		if (format)
+			glGetTexImage(GL_TEXTURE_2D, i + 1, format, GL_UNSIGNED_BYTE, (void*)offsets[i]);
+		else
+			glGetCompressedTexImage(GL_TEXTURE_2D, i + 1, (void*)offsets[i]);
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	glBindTexture(GL_TEXTURE_2D, id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int i = 0; i < levels; i++)
+	{
+		int levelWidth = std::max(1, width >> i);
+		int levelHeight = std::max(1, height >> i);
+		if (format)
+			glTexImage2D(GL_TEXTURE_2D, i, texture.internalFormat, levelWidth, levelHeight, 0, format, GL_UNSIGNED_BYTE,
+				(const void*)offsets[i]);
+		else
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, texture.internalFormat, levelWidth, levelHeight, 0,
+				(GLsizei)texture.levelSizes[texture.droppedLevels + 1 + i], (const void*)offsets[i]);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	// the driver keeps the storage until the copies are done
+	glDeleteBuffers(1, &buffer);
+}
+
+bool TextureResidency::DropTopLevel(Texture& texture)
+{
+	int dropped = texture.droppedLevels + 1;
+	int levels = texture.levelCount - 1;
+	int width = std::max(1, texture.width >> dropped);
+	int height = std::max(1, texture.height >> dropped);
+	if (levels < 1 || std::max(width, height) < minimumDropSize)
+		return false;
+	unsigned int id = 0;
+	glGenTextures(1, &id);
+	// copied on the GPU, nothing has to be decoded again; whole levels, so this
+	// works for block compressed formats too
+	if (GLAD_GL_VERSION_4_3)
+	{
+		glBindTexture(GL_TEXTURE_2D, id);
+		glTexStorage2D(GL_TEXTURE_2D, levels, texture.internalFormat, width, height);
+		for (int i = 0; i < levels; i++)
+		{
+			glCopyImageSubData(texture.ID, GL_TEXTURE_2D, i + 1, 0, 0, 0, id, GL_TEXTURE_2D, i, 0, 0, 0,
+				std::max(1, width >> i), std::max(1, height >> i), 1);
+		}
+	}
+	else
+		CopyThroughBuffer(texture, id, levels, width, height);
+	texture.Replace(id);
+	texture.levelCount = levels;
+	texture.droppedLevels = dropped;
+	texture.residentBytes -= texture.levelSizes[dropped - 1];
+	return true;
+}
+
+void TextureResidency::Update()
+{
+	Texture::frame++;
+	// textures released by their owners are forgotten
+	entries.erase(std::remove_if(entries.begin(), entries.end(),
+		[](const Entry& entry) { return entry.texture.expired(); }), entries.end());
+	std::vector<std::shared_ptr<Texture>> textures;
+	for (const Entry& entry : entries)
+		textures.push_back(entry.texture.lock());
+
+	// reloads in flight count at full size for evictions and restores, so what
+	// lands later fits as well
+	size_t pending = 0;
+	residentBytes = 0;
+	bool loaderIdle = loader.IsIdle();
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		Entry& entry = entries[i];
+		Texture& texture = *textures[i];
+		if (entry.reloading && texture.ready && texture.droppedLevels == 0)
+			entry.reloading = false;
+		else if (entry.reloading && loaderIdle)
+		{
+			entry.reloading = false;
+			entry.failed = true;
+		}
+		if (entry.reloading)
+			pending += GetFullSize(texture) - texture.residentBytes;
+		// evicted textures come back once they are bound again
+		else if (entry.evicted && !entry.failed && IsInUse(texture))
+		{
+			loader.Reload(textures[i], entry.options);
+			entry.reloading = true;
+			entry.evicted = false;
+			pending += GetFullSize(texture);
+		}
+		residentBytes += texture.residentBytes;
+	}
+
+	// least recently bound first, only uploaded textures hold memory
+	std::vector<size_t> order;
+	for (size_t i = 0; i < entries.size(); i++)
+		if (textures[i]->ready && !entries[i].reloading)
+			order.push_back(i);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+	{
+		return textures[a]->lastBound < textures[b]->lastBound;
+	});
+
+	// textures nobody draws go first
+	for (size_t i : order)
+	{
+		if (residentBytes + pending <= budget)
+			break;
+		Texture& texture = *textures[i];
+		if (IsInUse(texture))
+			break;
+		residentBytes -= texture.residentBytes;
+		Evict(entries[i], texture);
+	}
+	// what is left is drawn every frame, recency says nothing there: the largest
+	// loses its top level until the budget holds. Reloads in flight are left out,
+	// they are reduced themselves if they do not fit once they land
+	std::vector<size_t> reducible;
+	for (size_t i : order)
+		if (textures[i]->ready)
+			reducible.push_back(i);
+	while (residentBytes > budget && !reducible.empty())
+	{
+		auto largest = std::max_element(reducible.begin(), reducible.end(), [&](size_t a, size_t b)
+		{
+			return textures[a]->residentBytes < textures[b]->residentBytes;
+		});
+		Texture& texture = *textures[*largest];
+		size_t before = texture.residentBytes;
+		if (DropTopLevel(texture))
+			residentBytes -= before - texture.residentBytes;
+		else
+			reducible.erase(largest);
+	}
+	// reduced textures get their full chain back once it fits next to the other
+	// textures in use, the next Update evicts whatever else is in the way
+	size_t inUseBytes = 0;
+	for (size_t i : order)
+		if (textures[i]->ready && IsInUse(*textures[i]))
+			inUseBytes += textures[i]->residentBytes;
+	for (auto it = order.rbegin(); it != order.rend(); ++it)
+	{
+		Entry& entry = entries[*it];
+		Texture& texture = *textures[*it];
+		if (!texture.ready || !texture.droppedLevels || entry.failed || !IsInUse(texture))
+			continue;
+		size_t missing = GetFullSize(texture) - texture.residentBytes;
+		if (inUseBytes + pending + missing > budget)
+			continue;
+		loader.Reload(textures[*it], entry.options);
+		entry.reloading = true;
+		pending += missing;
+	}
+}
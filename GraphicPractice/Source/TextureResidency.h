@@ -0,0 +1,69 @@
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include "Texture.h"
+#include "TextureLoader.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Keeps the GPU memory of a TextureLoader's textures (every level counted) under
+// a budget. Once a frame, textures that were not bound last frame are evicted
+// least recently used first; when the textures in use alone do not fit, the
+// largest of them lose their top mip instead. Evicted textures are loaded again
+// when they are bound (they sample as incomplete until then), reduced ones get
+// their full chain back once it fits. Reloads go through TextureCache, so usually
+// they are a mapping and an upload. Render thread only.
+class TextureResidency
+{
+private:
+	struct Entry
+	{
+		std::weak_ptr<Texture> texture;
+		TextureOptions options;
+		// a reload was submitted and has not been uploaded yet
+		bool reloading = false;
+		bool evicted = false;
+		// a reload never landed (the file is gone or did not decode), it is left as it is
+		bool failed = false;
+	};
+
+	// textures are never reduced below this on their larger side
+	static const int minimumDropSize = 64;
+	TextureLoader& loader;
+	size_t budget;
+	std::vector<Entry> entries;
+	size_t residentBytes = 0;
+	// frames since the start, textures bound last frame are in use
+	unsigned long long frame = 0;
+
+	static size_t GetFullSize(const Texture& texture);
+	bool IsInUse(const Texture& texture) const;
+	void Evict(Entry& entry, Texture& texture);
+	// copies the lower levels to a new object one level smaller, false if the texture
+	// is as small as it gets
+	bool DropTopLevel(Texture& texture);
+	// DropTopLevel before 4.3 (no glCopyImageSubData): the levels are read into a
+	// buffer and specified again from it, the data never leaves the GPU
+	static void CopyThroughBuffer(const Texture& texture, unsigned int id, int levels, int width, int height);
+public:
+	// textures loaded through loader from now on are managed
+	TextureResidency(TextureLoader& loader, size_t budgetBytes = 256 * 1024 * 1024);
+	~TextureResidency();
+	TextureResidency(const TextureResidency&) = delete;
+	TextureResidency& operator=(const TextureResidency&) = delete;
+
+	// takes effect on the next Update
+	void SetBudget(size_t bytes) { budget = bytes; }
+	size_t GetBudget() const { return budget; }
+	// GPU bytes of all managed textures after the last Update
+	size_t GetResidentBytes() const { return residentBytes; }
+	// called by TextureLoader::Load
+	void Track(const std::shared_ptr<Texture>& texture, const TextureOptions& options);
+	// once a frame after TextureLoader::Update and before binding: reloads what was
+	// needed, then evicts and reduces until the budget holds
+	void Update();
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 2;
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::Run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	wakeUp.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	wakeUp.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this]() { return jobs.empty() && busy == 0; });
+}
+
+void ThreadPool::SetIdleTask(std::function<void()> task)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	idleTask = std::move(task);
+}
+
+void ThreadPool::Run()
+{
+	unsigned long long drainsSeen = 0;
+	while (true)
+	{
+		std::function<void()> job;
+		bool idleJob = false;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [&]() { return !running || !jobs.empty() || drainsSeen != drains; });
+			if (!jobs.empty())
+			{
+				job = std::move(jobs.front());
+				jobs.pop_front();
+				busy++;
+				// new work makes an earlier drain stale
+				drainsSeen = drains;
+			}
+			// queued jobs still run before shutdown
+			else if (!running)
+				return;
+			else
+			{
+				drainsSeen = drains;
+				job = idleTask;
+				idleJob = true;
+			}
+		}
+		if (job)
+			job();
+		if (idleJob)
+			continue;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busy--;
+			if (jobs.empty() && busy == 0)
+			{
+				idle.notify_all();
+				if (idleTask)
+				{
+					drains++;
+					wakeUp.notify_all();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running queued jobs (no GL calls in jobs)
+class ThreadPool
+{
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::condition_variable idle;
+	size_t busy = 0;
+	bool running = true;
+	std::function<void()> idleTask;
+	// times the pool drained, every worker runs idleTask once for each
+	unsigned long long drains = 0;
+
+	void Run();
+public:
+	// 0 threads means one per core
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Submit(std::function<void()> job);
+	// blocks until every submitted job has finished
+	void Wait();
+	// runs once on every worker whenever the queue drains and no job is running,
+	// for per thread caches that should not stay resident between bursts of work
+	void SetIdleTask(std::function<void()> task);
+	size_t GetThreadCount() const { return workers.size(); }
+};
+
+#endif
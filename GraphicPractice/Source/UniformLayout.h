@@ -0,0 +1,137 @@
+#ifndef UNIFORM_LAYOUT_H
+#define UNIFORM_LAYOUT_H
+
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+// GLSL types as plain C++ data, used to describe uniform/storage blocks
+struct Vec2 { float x, y; };
+struct Vec3 { float x, y, z; };
+struct Vec4 { float x, y, z, w; };
+struct IVec4 { int x, y, z, w; };
+// column major like GLSL
+struct Mat3 { float m[3][3]; };
+struct Mat4 { float m[4][4]; };
+// GLSL array member, T elements[N]
+template <typename T, size_t N>
+struct Array { T elements[N]; };
+
+enum class BufferLayout { Std140, Std430 };
+
+// base alignment and size of a member in a block
+template <BufferLayout L, typename T>
+struct LayoutTraits;
+
+template <BufferLayout L> struct LayoutTraits<L, float> { static constexpr size_t align = 4, size = 4; };
+template <BufferLayout L> struct LayoutTraits<L, int> { static constexpr size_t align = 4, size = 4; };
+template <BufferLayout L> struct LayoutTraits<L, unsigned int> { static constexpr size_t align = 4, size = 4; };
+// GLSL bool is 4 bytes in a block
+template <BufferLayout L> struct LayoutTraits<L, bool> { static constexpr size_t align = 4, size = 4; };
+template <BufferLayout L> struct LayoutTraits<L, Vec2> { static constexpr size_t align = 8, size = 8; };
+template <BufferLayout L> struct LayoutTraits<L, Vec3> { static constexpr size_t align = 16, size = 12; };
+template <BufferLayout L> struct LayoutTraits<L, Vec4> { static constexpr size_t align = 16, size = 16; };
+template <BufferLayout L> struct LayoutTraits<L, IVec4> { static constexpr size_t align = 16, size = 16; };
+// matrix columns are laid out like an array of vec4 in both layouts
+template <BufferLayout L> struct LayoutTraits<L, Mat3> { static constexpr size_t align = 16, size = 48; };
+template <BufferLayout L> struct LayoutTraits<L, Mat4> { static constexpr size_t align = 16, size = 64; };
+
+constexpr size_t AlignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+template <BufferLayout L, typename T, size_t N>
+struct LayoutTraits<L, Array<T, N>>
+{
+	// std140 rounds array elements up to vec4, std430 does not
+	static constexpr size_t align = L == BufferLayout::Std140 ? AlignUp(LayoutTraits<L, T>::align, 16) : LayoutTraits<L, T>::align;
+	static constexpr size_t stride = AlignUp(LayoutTraits<L, T>::size, align);
+	static constexpr size_t size = stride * N;
+};
+
+// Offsets of a block computed at compile time from its member types, e.g.
+// BlockLayout<BufferLayout::Std140, Mat4, Vec3, float> matches
+// layout(std140) uniform Block { mat4 a; vec3 b; float c; };
+template <BufferLayout L, typename... Members>
+struct BlockLayout
+{
+	static constexpr BufferLayout layout = L;
+	static constexpr size_t count = sizeof...(Members);
+
+	template <size_t I>
+	using MemberType = typename std::tuple_element<I, std::tuple<Members...>>::type;
+
+	// offset of member I
+	template <size_t I>
+	static constexpr size_t Offset()
+	{
+		constexpr size_t aligns[] = { LayoutTraits<L, Members>::align... };
+		constexpr size_t sizes[] = { LayoutTraits<L, Members>::size... };
+		size_t offset = 0;
+		for (size_t i = 0; i <= I; i++)
+		{
+			offset = AlignUp(offset, aligns[i]);
+			if (i < I)
+				offset += sizes[i];
+		}
+		return offset;
+	}
+
+	static constexpr size_t MaxAlign()
+	{
+		constexpr size_t aligns[] = { LayoutTraits<L, Members>::align... };
+		size_t result = L == BufferLayout::Std140 ? 16 : 4;
+		for (size_t align : aligns)
+			result = align > result ? align : result;
+		return result;
+	}
+
+	// block size, padded like the GL does
+	static constexpr size_t Size()
+	{
+		return AlignUp(Offset<count - 1>() + LayoutTraits<L, MemberType<count - 1>>::size, MaxAlign());
+	}
+};
+
+// CPU copy of a block laid out by BlockLayout, ready to memcpy into a buffer
+template <typename Layout>
+class UniformBlock
+{
+private:
+	alignas(16) unsigned char data[Layout::Size()] = {};
+
+	template <typename T>
+	static void Write(unsigned char* dst, const T& value)
+	{
+		memcpy(dst, &value, sizeof(T));
+	}
+	template <typename T, size_t N>
+	static void Write(unsigned char* dst, const Array<T, N>& value)
+	{
+		for (size_t i = 0; i < N; i++)
+			Write(dst + i * LayoutTraits<Layout::layout, Array<T, N>>::stride, value.elements[i]);
+	}
+	static void Write(unsigned char* dst, bool value)
+	{
+		int v = value ? 1 : 0;
+		memcpy(dst, &v, sizeof(v));
+	}
+	static void Write(unsigned char* dst, const Mat3& value)
+	{
+		// each column padded to a vec4
+		for (int c = 0; c < 3; c++)
+			memcpy(dst + c * 16, value.m[c], sizeof(value.m[c]));
+	}
+public:
+	template <size_t I>
+	void Set(const typename Layout::template MemberType<I>& value)
+	{
+		Write(data + Layout::template Offset<I>(), value);
+	}
+	const void* GetData() const { return data; }
+	static constexpr size_t Size() { return Layout::Size(); }
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "UniformRingBuffer.h"
+
+#include <cstring>
+#include <iostream>
+
+UniformRingBuffer::UniformRingBuffer(GLsizeiptr regionSize, GLenum target)
+	: target(target)
+{
+	int major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major < 4 || (major == 4 && minor < 4))
+	{
+		std::cout << "ERROR::UNIFORM_RING_BUFFER::NEEDS_GL_4_4" << std::endl;
+		return;
+	}
+	// offsets of glBindBufferRange must respect the driver alignment
+	int offsetAlignment = 0;
+	glGetIntegerv(target == GL_SHADER_STORAGE_BUFFER ? GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+		: GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	if (offsetAlignment > 0)
+		alignment = offsetAlignment;
+	this->regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+	glBufferStorage(target, this->regionSize * regionCount, NULL, flags);
+	mapped = (unsigned char*)glMapBufferRange(target, 0, this->regionSize * regionCount, flags);
+	if (!mapped)
+		std::cout << "ERROR::UNIFORM_RING_BUFFER::MAP_FAILED" << std::endl;
+}
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+	for (GLsync fence : fences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+	}
+	if (buffer != 0)
+	{
+		if (mapped)
+		{
+			glBindBuffer(target, buffer);
+			glUnmapBuffer(target);
+		}
+		glDeleteBuffers(1, &buffer);
+	}
+}
+
+void UniformRingBuffer::BeginFrame()
+{
+	region = (region + 1) % regionCount;
+	head = 0;
+	GLsync fence = fences[region];
+	if (!fence)
+		return;
+	// normally already signaled, only blocks if the CPU is regionCount frames ahead
+	GLbitfield flags = 0;
+	while (true)
+	{
+		GLenum result = glClientWaitSync(fence, flags, 1000000);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+			break;
+		flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	}
+	glDeleteSync(fence);
+	fences[region] = 0;
+}
+
+void UniformRingBuffer::EndFrame()
+{
+	if (fences[region])
+		glDeleteSync(fences[region]);
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+RingAllocation UniformRingBuffer::Allocate(GLsizeiptr size)
+{
+	RingAllocation allocation;
+	GLsizeiptr alignedSize = (size + alignment - 1) / alignment * alignment;
+	if (!mapped || head + alignedSize > regionSize)
+	{
+		std::cout << "ERROR::UNIFORM_RING_BUFFER::OUT_OF_SPACE" << std::endl;
+		return allocation;
+	}
+	allocation.offset = region * regionSize + head;
+	allocation.size = size;
+	allocation.data = mapped + allocation.offset;
+	head += alignedSize;
+	return allocation;
+}
+
+RingAllocation UniformRingBuffer::Push(const void* data, GLsizeiptr size)
+{
+	RingAllocation allocation = Allocate(size);
+	if (allocation.IsValid())
+		memcpy(allocation.data, data, size);
+	return allocation;
+}
+
+void UniformRingBuffer::Bind(unsigned int binding, const RingAllocation& allocation) const
+{
+	glBindBufferRange(target, binding, buffer, allocation.offset, allocation.size);
+}
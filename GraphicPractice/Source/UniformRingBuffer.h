@@ -0,0 +1,55 @@
+#ifndef UNIFORM_RING_BUFFER_H
+#define UNIFORM_RING_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// piece of the ring handed out for one draw
+struct RingAllocation
+{
+	// write the block here, the memory is visible to the GPU without any GL call
+	void* data = nullptr;
+	// offset inside the buffer for glBindBufferRange
+	GLintptr offset = 0;
+	GLsizeiptr size = 0;
+	bool IsValid() const { return data != nullptr; }
+};
+
+// Persistently mapped buffer (GL 4.4 glBufferStorage) split into one region
+// per frame in flight. Every draw gets its own sub-allocation, the CPU only
+// waits when it laps the GPU, guarded by a fence per region.
+class UniformRingBuffer
+{
+private:
+	static const int regionCount = 3;
+	unsigned int buffer = 0;
+	GLenum target;
+	unsigned char* mapped = nullptr;
+	GLsizeiptr regionSize = 0;
+	GLsizeiptr alignment = 256;
+	int region = 0;
+	GLsizeiptr head = 0;
+	GLsync fences[regionCount] = {};
+public:
+	// regionSize bytes are available per frame, target is GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+	explicit UniformRingBuffer(GLsizeiptr regionSize, GLenum target = GL_UNIFORM_BUFFER);
+	~UniformRingBuffer();
+	UniformRingBuffer(const UniformRingBuffer&) = delete;
+	UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+	bool IsValid() const { return mapped != nullptr; }
+	// moves to the next region, waits until the GPU is done with it
+	void BeginFrame();
+	// fences the region of this frame, call after its last draw
+	void EndFrame();
+	// aligned space for size bytes, invalid when the region is full
+	RingAllocation Allocate(GLsizeiptr size);
+	// copies the data in and returns the allocation
+	RingAllocation Push(const void* data, GLsizeiptr size);
+	// binds an allocation to a block binding point
+	void Bind(unsigned int binding, const RingAllocation& allocation) const;
+	unsigned int GetID() const { return buffer; }
+};
+
+#endif
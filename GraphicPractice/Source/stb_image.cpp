@@ -1,2 +1,19 @@
+// AVX2 JPEG kernels, installed per decode when the CPU has them
+#include "JpegKernels.h"
+#define STBI_JPEG_KERNEL_HOOK JpegKernels::Install
+
+// faster PNG decoding: SIMD row defilters and an inflate fast path
+#include "PngKernels.h"
+#if PNG_FAST_DECODE
+#define STBI_PNG_UNFILTER_HOOK PngKernels::Unfilter
+#define STBI_FAST_INFLATE
+#endif
+
+// decode buffers come from a per thread arena inside a DecodeArena::Scope
+#include "DecodeArena.h"
+#define STBI_MALLOC(size) DecodeArena::Allocate(size)
+#define STBI_REALLOC_SIZED(pointer, oldSize, newSize) DecodeArena::Reallocate(pointer, oldSize, newSize)
+#define STBI_FREE(pointer) DecodeArena::Free(pointer)
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
\ No newline at end of file
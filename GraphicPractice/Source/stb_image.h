@@ -3776,6 +3776,11 @@ static void stbi__setup_jpeg(stbi__jpeg *j)
    j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
    j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_simd;
 #endif
+
+#ifdef STBI_JPEG_KERNEL_HOOK
+   // lets the embedding code swap in wider kernels with the same output
+   STBI_JPEG_KERNEL_HOOK(j->YCbCr_to_RGB_kernel, j->resample_row_hv_2_kernel);
+#endif
 }
 
 // clean up the temporary component buffers
@@ -4122,6 +4127,9 @@ typedef struct
    int   z_expandable;
 
    stbi__zhuffman z_length, z_distance;
+#ifdef STBI_FAST_INFLATE
+   stbi__uint32 z_pairs[1 << 11];
+#endif
 } stbi__zbuf;
 
 stbi_inline static int stbi__zeof(stbi__zbuf *z)
@@ -4230,11 +4238,141 @@ static const int stbi__zdist_base[32] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129
 static const int stbi__zdist_extra[32] =
 { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
 
+#ifdef STBI_FAST_INFLATE
+// Fast path for the bulk of a huffman block (little endian targets): a 64-bit
+// bit buffer refilled 8 bytes at a time, up to two literals per table lookup
+// and matches copied 8 bytes at a time. It runs while 8 input bytes and a
+// longest match plus slack of output are left, and hands the end of the block
+// and corrupt data back to the generic loop.
+#define STBI__ZPAIR_BITS  11
+#define STBI__ZPAIR_MASK  ((1 << STBI__ZPAIR_BITS) - 1)
+
+// entry = first literal | second literal << 8 | bits used << 16 | literal count << 24
+static void stbi__zbuild_pairs(stbi__zbuf *a)
+{
+   int i;
+   for (i=0; i < (1 << STBI__ZPAIR_BITS); ++i) {
+      int e1 = a->z_length.fast[i & STBI__ZFAST_MASK];
+      int s1 = e1 >> 9;
+      stbi__uint32 entry = 0;
+      if (e1 && (e1 & 511) < 256) {
+         // the second code has to fit in the bits the index still knows
+         int e2 = a->z_length.fast[(i >> s1) & STBI__ZFAST_MASK];
+         int s2 = e2 >> 9;
+         entry = (stbi__uint32) (e1 & 511) | ((stbi__uint32) s1 << 16) | (1u << 24);
+         if (e2 && (e2 & 511) < 256 && s1 + s2 <= STBI__ZPAIR_BITS)
+            entry = (stbi__uint32) (e1 & 511) | ((stbi__uint32) (e2 & 511) << 8) | ((stbi__uint32) (s1 + s2) << 16) | (2u << 24);
+      }
+      a->z_pairs[i] = entry;
+   }
+}
+
+// codes longer than STBI__ZFAST_BITS, as (size << 9) | value like a fast table entry, 0 if invalid
+static int stbi__zhuffman_decode_long(stbi__zhuffman *z, unsigned long long bits)
+{
+   int b,s;
+   int k = stbi__bit_reverse((int) (bits & 0xffff), 16);
+   for (s=STBI__ZFAST_BITS+1; s < 16; ++s)
+      if (k < z->maxcode[s])
+         break;
+   if (s >= 16) return 0;
+   b = (k >> (16-s)) - z->firstcode[s] + z->firstsymbol[s];
+   if (b >= STBI__ZNSYMS || z->size[b] != s) return 0;
+   return (s << 9) | z->value[b];
+}
+
+static char *stbi__parse_huffman_fast(stbi__zbuf *a, char *zout)
+{
+   stbi_uc *in = a->zbuffer;
+   unsigned long long bits = a->code_buffer;
+   int num_bits = a->num_bits;
+   // a refill leaves at least 56 bits, enough for a length, a distance and their extra bits
+   while (a->zbuffer_end - in >= 8 && a->zout_end - zout >= 258 + 8) {
+      unsigned long long next, saved_bits;
+      int saved_num_bits, e, z, len, dist;
+      stbi_uc *p;
+      memcpy(&next, in, 8);
+      bits |= next << num_bits;
+      in += (63 - num_bits) >> 3;
+      num_bits |= 56;
+
+      e = (int) a->z_pairs[bits & STBI__ZPAIR_MASK];
+      if (e >> 24) {
+         // the second byte is written either way, a single literal leaves it to be overwritten
+         zout[0] = (char) e;
+         zout[1] = (char) (e >> 8);
+         zout += e >> 24;
+         bits >>= (e >> 16) & 31;
+         num_bits -= (e >> 16) & 31;
+         continue;
+      }
+
+      saved_bits = bits;
+      saved_num_bits = num_bits;
+      e = a->z_length.fast[bits & STBI__ZFAST_MASK];
+      if (!e) e = stbi__zhuffman_decode_long(&a->z_length, bits);
+      z = e & 511;
+      if (!e || z == 256 || z > 285) break;
+      bits >>= e >> 9;
+      num_bits -= e >> 9;
+      if (z < 256) {
+         *zout++ = (char) z;
+         continue;
+      }
+      z -= 257;
+      len = stbi__zlength_base[z];
+      if (stbi__zlength_extra[z]) {
+         len += (int) (bits & ((1u << stbi__zlength_extra[z]) - 1));
+         bits >>= stbi__zlength_extra[z];
+         num_bits -= stbi__zlength_extra[z];
+      }
+      e = a->z_distance.fast[bits & STBI__ZFAST_MASK];
+      if (!e) e = stbi__zhuffman_decode_long(&a->z_distance, bits);
+      z = e & 511;
+      if (!e || z >= 30) { bits = saved_bits; num_bits = saved_num_bits; break; }
+      bits >>= e >> 9;
+      num_bits -= e >> 9;
+      dist = stbi__zdist_base[z];
+      if (stbi__zdist_extra[z]) {
+         dist += (int) (bits & ((1u << stbi__zdist_extra[z]) - 1));
+         bits >>= stbi__zdist_extra[z];
+         num_bits -= stbi__zdist_extra[z];
+      }
+      if (zout - a->zout_start < dist) { bits = saved_bits; num_bits = saved_num_bits; break; }
+
+      p = (stbi_uc *) (zout - dist);
+      if (dist >= 8) {
+         // chunks never read bytes they have not written yet, the overshoot lands in the slack
+         char *end = zout + len;
+         do { memcpy(zout, p, 8); zout += 8; p += 8; } while (zout < end);
+         zout = end;
+      } else if (dist == 1) {
+         memset(zout, *p, len);
+         zout += len;
+      } else {
+         do *zout++ = *p++; while (--len);
+      }
+   }
+   // give back the whole bytes still in the buffer, the generic code keeps 32 bits
+   a->zbuffer = in - (num_bits >> 3);
+   a->num_bits = num_bits & 7;
+   a->code_buffer = (stbi__uint32) (bits & ((1u << a->num_bits) - 1));
+   return zout;
+}
+#endif
+
 static int stbi__parse_huffman_block(stbi__zbuf *a)
 {
    char *zout = a->zout;
+#ifdef STBI_FAST_INFLATE
+   stbi__zbuild_pairs(a);
+#endif
    for(;;) {
-      int z = stbi__zhuffman_decode(a, &a->z_length);
+      int z;
+#ifdef STBI_FAST_INFLATE
+      zout = stbi__parse_huffman_fast(a, zout);
+#endif
+      z = stbi__zhuffman_decode(a, &a->z_length);
       if (z < 256) {
          if (z < 0) return stbi__err("bad huffman code","Corrupt PNG"); // error in huffman codes
          if (zout >= a->zout_end) {
@@ -4665,10 +4803,15 @@ static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 r
       // this is a little gross, so that we don't switch per-pixel or per-component
       if (depth < 8 || img_n == out_n) {
          int nk = (width - 1)*filter_bytes;
+         int handled = 0;
+#ifdef STBI_PNG_UNFILTER_HOOK
+         // lets the embedding code unfilter whole rows with wider kernels, nonzero if it did
+         if (depth >= 8) handled = STBI_PNG_UNFILTER_HOOK(filter, cur, prior, raw, nk, filter_bytes);
+#endif
          #define STBI__CASE(f) \
              case f:     \
                 for (k=0; k < nk; ++k)
-         switch (filter) {
+         if (!handled) switch (filter) {
             // "none" filter turns into a memcpy here; make that explicit.
             case STBI__F_none:         memcpy(cur, raw, nk); break;
             STBI__CASE(STBI__F_sub)          { cur[k] = STBI__BYTECAST(raw[k] + cur[k-filter_bytes]); } break;
@@ -0,0 +1,62 @@
+// Asset archive packer
+// --------------------
+// Packs loose assets into one archive (see Source/AssetArchive.h) so the game
+// maps a single file at startup instead of opening every texture and shader.
+// Directories are added recursively; names are the paths as given, so run it
+// from the directory the game loads assets from.
+//
+// Usage (run from the GraphicPractice directory, build together with
+// Source/AssetArchive.cpp, Source/BlockCompression.cpp and Source/MappedFile.cpp):
+//     AssetPack Assets.pak container.jpg awesomeface.png Resources/Shaders
+// --store skips compression for every file.
+
+#include "../../Source/AssetArchive.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "usage: AssetPack [--store] <archive> <file or directory>..." << std::endl;
+		return 1;
+	}
+	int arg = 1;
+	bool compress = true;
+	if (strcmp(argv[arg], "--store") == 0)
+	{
+		compress = false;
+		arg++;
+	}
+	std::string archivePath = argv[arg++];
+
+	// (archive name, file on disk)
+	std::vector<std::pair<std::string, std::string>> files;
+	for (; arg < argc; arg++)
+	{
+		std::filesystem::path input = argv[arg];
+		std::error_code error;
+		if (std::filesystem::is_directory(input, error))
+		{
+			for (const auto& item : std::filesystem::recursive_directory_iterator(input, error))
+			{
+				if (item.is_regular_file())
+					files.emplace_back(item.path().generic_string(), item.path().string());
+			}
+		}
+		else if (std::filesystem::is_regular_file(input, error))
+			files.emplace_back(input.generic_string(), input.string());
+		else
+		{
+			std::cout << "ERROR::ASSET_PACK::NOT_FOUND " << input.string() << std::endl;
+			return 1;
+		}
+	}
+
+	if (!AssetArchive::Write(archivePath, files, compress))
+		return 1;
+	std::cout << "packed " << files.size() << " files into " << archivePath << std::endl;
+	return 0;
+}
@@ -0,0 +1,58 @@
+// Texture atlas layout packer
+// ---------------------------
+// Packs the images given on the command line into one atlas with the skyline
+// packer and writes the layout (see TextureAtlas::SaveLayout). At runtime the
+// decoded images go to TextureAtlas::Build with the loaded rects, so no packing
+// happens during load and the layout stays stable between runs.
+// Only the image headers are read (stbi_info), nothing is decoded.
+//
+// Usage (run from the GraphicPractice directory, build together with
+// Source/TextureAtlas.cpp, Source/TextureImage.cpp, Source/MappedFile.cpp,
+// Source/SkylinePacker.cpp, Source/stb_image.cpp and glad.c):
+//     AtlasPack materials.atlas 2048 2048 4 container.jpg awesomeface.png
+// Arguments are the layout file, atlas width, atlas height, padding and the images.
+
+#include "../../Source/TextureAtlas.h"
+#include "../../Source/stb_image.h"
+
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+	if (argc < 6)
+	{
+		std::cout << "usage: AtlasPack <layout> <width> <height> <padding> <image>..." << std::endl;
+		return 1;
+	}
+	std::string layoutPath = argv[1];
+	int width = atoi(argv[2]);
+	int height = atoi(argv[3]);
+	int padding = atoi(argv[4]);
+
+	std::vector<std::string> names;
+	std::vector<PackedRect> sizes;
+	for (int arg = 5; arg < argc; arg++)
+	{
+		PackedRect size;
+		int channels;
+		if (!stbi_info(argv[arg], &size.width, &size.height, &channels))
+		{
+			std::cout << "ERROR::ATLAS_PACK::CANNOT_READ " << argv[arg] << ": " << stbi_failure_reason() << std::endl;
+			return 1;
+		}
+		names.push_back(argv[arg]);
+		sizes.push_back(size);
+	}
+
+	std::vector<PackedRect> rects;
+	if (!TextureAtlas::Pack(sizes, width, height, padding, rects))
+	{
+		std::cout << "ERROR::ATLAS_PACK::DOES_NOT_FIT " << width << "x" << height << std::endl;
+		return 1;
+	}
+	if (!TextureAtlas::SaveLayout(layoutPath, width, height, padding, names, rects))
+		return 1;
+	std::cout << "packed " << names.size() << " images into " << layoutPath << std::endl;
+	return 0;
+}
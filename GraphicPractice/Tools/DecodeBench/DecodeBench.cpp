@@ -0,0 +1,175 @@
+// Image decode throughput benchmark
+// ---------------------------------
+// Reads a corpus of images into memory once, then decodes every file with
+// stb_image a number of times and prints pixel and byte throughput per
+// format. With --compare every JPEG is also decoded with stb_image's own
+// kernels, alternating with JpegKernels, and the speedup is printed.
+// The PNG fast path is a compile flag, so PNG is compared by building the
+// tool twice, once with -DPNG_FAST_DECODE=0, and running both on one corpus.
+//
+// Usage (run from the GraphicPractice directory, build together with
+// Source/stb_image.cpp, Source/JpegKernels.cpp, Source/PngKernels.cpp and
+// Source/CpuFeatures.cpp):
+//     DecodeBench container.jpg awesomeface.png
+//     DecodeBench --compare --iterations 20 Resources/Textures
+// Directories are searched recursively for .jpg, .jpeg and .png files.
+
+#include "../../Source/JpegKernels.h"
+#include "../../Source/PngKernels.h"
+#include "../../Source/stb_image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+struct CorpusFile
+{
+	std::string path;
+	std::string format;
+	std::vector<unsigned char> data;
+};
+
+struct Totals
+{
+	int files = 0;
+	double pixels = 0.0;
+	double bytes = 0.0;
+	double milliseconds = 0.0;
+};
+
+static std::string Extension(const std::filesystem::path& path)
+{
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+	return extension == ".jpeg" ? ".jpg" : extension;
+}
+
+static void AddFile(const std::filesystem::path& path, std::vector<CorpusFile>& corpus)
+{
+	std::string extension = Extension(path);
+	if (extension != ".jpg" && extension != ".png")
+		return;
+	std::ifstream file(path, std::ios::binary);
+	CorpusFile entry;
+	entry.path = path.string();
+	entry.format = extension.substr(1);
+	entry.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	if (!entry.data.empty())
+		corpus.push_back(std::move(entry));
+}
+
+// best decode time of one file in milliseconds, negative if it fails
+static double Decode(const CorpusFile& file, int& width, int& height)
+{
+	int channels;
+	auto start = std::chrono::steady_clock::now();
+	unsigned char* pixels = stbi_load_from_memory(file.data.data(), (int)file.data.size(), &width, &height, &channels, 0);
+	double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	if (!pixels)
+	{
+		std::cout << "ERROR::DECODE_BENCH::DECODE_FAILED " << file.path << ": " << stbi_failure_reason() << std::endl;
+		return -1.0;
+	}
+	stbi_image_free(pixels);
+	return elapsed;
+}
+
+static void Add(Totals& totals, const CorpusFile& file, int width, int height, double milliseconds)
+{
+	totals.files++;
+	totals.pixels += (double)width * height;
+	totals.bytes += (double)file.data.size();
+	totals.milliseconds += milliseconds;
+}
+
+// decodes every file of one format, best of the iterations per file; with compare
+// the two kernel sets alternate so both see the same clock and cache state
+static void Run(const std::vector<CorpusFile>& corpus, const std::string& format, int iterations, bool compare,
+	Totals& kernels, Totals& baseline)
+{
+	for (const CorpusFile& file : corpus)
+	{
+		if (file.format != format)
+			continue;
+		double best = 1e30, bestBaseline = 1e30;
+		int width = 0, height = 0;
+		for (int i = 0; i < iterations && best >= 0.0; i++)
+		{
+			if (compare)
+			{
+				JpegKernels::SetEnabled(false);
+				bestBaseline = std::min(bestBaseline, Decode(file, width, height));
+				JpegKernels::SetEnabled(true);
+			}
+			best = std::min(best, Decode(file, width, height));
+		}
+		if (best < 0.0)
+			continue;
+		Add(kernels, file, width, height, best);
+		if (compare)
+			Add(baseline, file, width, height, bestBaseline);
+	}
+}
+
+static void Print(const std::string& label, const Totals& totals)
+{
+	std::cout << label << ": " << totals.files << " files, " << totals.milliseconds << " ms, "
+		<< totals.pixels / 1000.0 / totals.milliseconds << " MPix/s, "
+		<< totals.bytes / 1000.0 / totals.milliseconds << " MB/s compressed" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	bool compare = false;
+	int iterations = 10;
+	std::vector<CorpusFile> corpus;
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (strcmp(argv[arg], "--compare") == 0)
+			compare = true;
+		else if (strcmp(argv[arg], "--iterations") == 0 && arg + 1 < argc)
+			iterations = std::max(atoi(argv[++arg]), 1);
+		else if (std::filesystem::is_directory(argv[arg]))
+		{
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(argv[arg]))
+				if (entry.is_regular_file())
+					AddFile(entry.path(), corpus);
+		}
+		else
+			AddFile(argv[arg], corpus);
+	}
+	if (corpus.empty())
+	{
+		std::cout << "usage: DecodeBench [--compare] [--iterations <n>] <image or directory>..." << std::endl;
+		return 1;
+	}
+
+	std::cout << "JpegKernels " << (JpegKernels::IsActive() ? "active" : "not available")
+		<< ", PNG fast decode " << (PNG_FAST_DECODE ? "on" : "off") << ", best of " << iterations << std::endl;
+	for (const char* format : { "jpg", "png" })
+	{
+		bool jpeg = strcmp(format, "jpg") == 0;
+		Totals kernels, baseline;
+		Run(corpus, format, iterations, compare && jpeg, kernels, baseline);
+		if (kernels.files == 0)
+			continue;
+		if (compare && jpeg)
+		{
+			Print("jpg stb_image kernels", baseline);
+			Print("jpg JpegKernels", kernels);
+			std::cout << "jpg speedup: " << baseline.milliseconds / kernels.milliseconds << "x" << std::endl;
+		}
+		else
+			Print(format, kernels);
+	}
+	return 0;
+}
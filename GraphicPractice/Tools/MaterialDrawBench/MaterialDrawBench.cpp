@@ -0,0 +1,280 @@
+// Material draw throughput benchmark
+// ----------------------------------
+// Draws one small quad per material into an offscreen framebuffer in a hidden
+// GLFW context, three ways:
+//     binds    a texture per material: glActiveTexture and glBindTexture before
+//              every draw, like the render loop in Source.cpp does per texture
+//     array    every material a layer of one TextureArray, bound once per pass
+//     atlas    every material a region of one TextureAtlas, bound once per pass
+// Nothing else changes between draws: the material index comes from the first
+// vertex of glDrawArrays (gl_VertexID / 4) and picks the quad position, the
+// layer or the atlas region (a uniform block), so the texture binds are the
+// only per-draw state. Quads are a few pixels, which keeps rasterization out
+// of the numbers on software drivers. Printed is draws per second for a
+// growing material count, best of the iterations with glFinish after every
+// pass, the first pass is discarded.
+//
+// Usage (run from the GraphicPractice directory, build together with Source/*.cpp
+// except Source.cpp):
+//     MaterialDrawBench
+//     MaterialDrawBench --max 256 --draws 50000 --iterations 5
+
+#include "../../Source/Shader.h"
+#include "../../Source/TextureArray.h"
+#include "../../Source/TextureAtlas.h"
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+static const int imageSize = 32;
+static const int atlasSize = 4096;
+static const int targetSize = 128;
+// the atlas regions are one vec4 each in a uniform block, 16KB is the minimum block size
+static const int maxRegions = 1024;
+
+// quads on a 32x32 grid across the target, the material index is gl_VertexID / 4
+static const char* vertexHeader =
+	"#version 330 core\n"
+	"out vec2 TexCoord;\n"
+	"flat out int Material;\n"
+	"layout (std140) uniform Regions\n{\n\tvec4 regions[1024];\n};\n";
+static const char* vertexBody =
+	"void main()\n{\n"
+	"\tMaterial = gl_VertexID / 4;\n"
+	"\tvec2 corner = vec2(gl_VertexID & 1, (gl_VertexID >> 1) & 1);\n"
+	"\tvec2 cell = vec2(Material % 32, Material / 32 % 32);\n"
+	"\tgl_Position = vec4((cell + corner) / 16.0 - 1.0, 0.0, 1.0);\n"
+	"#ifdef ATLAS\n"
+	"\tTexCoord = corner * regions[Material].xy + regions[Material].zw;\n"
+	"#else\n"
+	"\tTexCoord = corner;\n"
+	"#endif\n"
+	"}\n";
+static const char* textureSource =
+	"#version 330 core\nout vec4 FragColor;\nin vec2 TexCoord;\nflat in int Material;\n"
+	"uniform sampler2D image;\n"
+	"void main()\n{\n\tFragColor = texture(image, TexCoord);\n}\n";
+static const char* arraySource =
+	"#version 330 core\nout vec4 FragColor;\nin vec2 TexCoord;\nflat in int Material;\n"
+	"uniform sampler2DArray image;\n"
+	"void main()\n{\n\tFragColor = texture(image, vec3(TexCoord, float(Material)));\n}\n";
+
+// a flat colour per material, the content does not matter
+static void MakeImage(TextureImage& image, int index)
+{
+	std::vector<unsigned char> pixels(imageSize * imageSize * 4);
+	for (size_t i = 0; i < pixels.size(); i += 4)
+	{
+		pixels[i] = (unsigned char)(index * 37);
+		pixels[i + 1] = (unsigned char)(index * 91);
+		pixels[i + 2] = (unsigned char)(index * 13);
+		pixels[i + 3] = 255;
+	}
+	image.Assign(pixels.data(), imageSize, imageSize, 4);
+	image.BuildMips(MipFilter::Box, false);
+}
+
+static unsigned int MakeTexture(const TextureImage& image)
+{
+	unsigned int id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D, id);
+	for (size_t level = 0; level < image.levels.size(); level++)
+		glTexImage2D(GL_TEXTURE_2D, (int)level, GL_RGBA8, image.levels[level].width, image.levels[level].height, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, image.GetLevelData(level));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return id;
+}
+
+static unsigned int MakeProgram(const char* fragmentSource, bool atlas)
+{
+	std::string vertex = std::string(vertexHeader) + (atlas ? "#define ATLAS\n" : "") + vertexBody;
+	unsigned int program = Shader::BuildProgram(vertex, fragmentSource);
+	if (program == 0)
+		return 0;
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "image"), 0);
+	unsigned int block = glGetUniformBlockIndex(program, "Regions");
+	if (block != GL_INVALID_INDEX)
+		glUniformBlockBinding(program, block, 0);
+	return program;
+}
+
+// best of the iterations in draws per second, pass() draws every material once
+template <typename Pass>
+static double Time(int frames, int iterations, int draws, Pass pass)
+{
+	double best = 0.0;
+	for (int i = 0; i <= iterations; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; frame++)
+			pass();
+		glFinish();
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		// the first pass only warms up
+		if (i > 0)
+			best = std::max(best, (double)frames * draws / elapsed);
+	}
+	return best;
+}
+
+int main(int argc, char** argv)
+{
+	int maxMaterials = maxRegions;
+	int drawsPerPass = 100000;
+	int iterations = 3;
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (strcmp(argv[arg], "--max") == 0 && arg + 1 < argc)
+			maxMaterials = std::min(std::max(atoi(argv[++arg]), 1), maxRegions);
+		else if (strcmp(argv[arg], "--draws") == 0 && arg + 1 < argc)
+			drawsPerPass = std::max(atoi(argv[++arg]), 1);
+		else if (strcmp(argv[arg], "--iterations") == 0 && arg + 1 < argc)
+			iterations = std::max(atoi(argv[++arg]), 1);
+		else
+		{
+			std::cout << "usage: MaterialDrawBench [--max <materials, up to 1024>] [--draws <per pass>] [--iterations <n>]" << std::endl;
+			return 1;
+		}
+	}
+
+	// hidden window, drawing goes to a framebuffer of its own
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	GLFWwindow* window = glfwCreateWindow(1, 1, "MaterialDrawBench", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return 1;
+	}
+
+	// an array cannot hold more layers than the driver allows
+	int maxLayers = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	maxMaterials = std::min(maxMaterials, maxLayers);
+
+	unsigned int framebuffer, colorBuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, targetSize, targetSize);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::MATERIAL_DRAW_BENCH::FRAMEBUFFER_INCOMPLETE" << std::endl;
+		return 1;
+	}
+	glViewport(0, 0, targetSize, targetSize);
+	// vertices come from gl_VertexID, core profile still wants a vertex array bound
+	unsigned int vertexArray;
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+
+	std::vector<TextureImage> images(maxMaterials);
+	std::vector<const TextureImage*> imagePointers;
+	std::vector<unsigned int> textures;
+	for (int i = 0; i < maxMaterials; i++)
+	{
+		MakeImage(images[i], i);
+		imagePointers.push_back(&images[i]);
+		textures.push_back(MakeTexture(images[i]));
+	}
+	TextureArray array;
+	TextureAtlas atlas;
+	if (!array.Build(imagePointers) || !atlas.Build(imagePointers, atlasSize, atlasSize))
+	{
+		std::cout << "ERROR::MATERIAL_DRAW_BENCH::PACK_FAILED" << std::endl;
+		return 1;
+	}
+	// uv scale and offset of every region, the block is always full size
+	std::vector<float> regions(maxRegions * 4, 0.0f);
+	for (size_t i = 0; i < atlas.GetRegionCount(); i++)
+	{
+		const AtlasRegion& region = atlas.GetRegion(i);
+		regions[i * 4] = region.uvScale[0];
+		regions[i * 4 + 1] = region.uvScale[1];
+		regions[i * 4 + 2] = region.uvOffset[0];
+		regions[i * 4 + 3] = region.uvOffset[1];
+	}
+	unsigned int regionBuffer;
+	glGenBuffers(1, &regionBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, regionBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, regions.size() * sizeof(float), regions.data(), GL_STATIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 0, regionBuffer);
+
+	unsigned int textureProgram = MakeProgram(textureSource, false);
+	unsigned int arrayProgram = MakeProgram(arraySource, false);
+	unsigned int atlasProgram = MakeProgram(textureSource, true);
+	if (textureProgram == 0 || arrayProgram == 0 || atlasProgram == 0)
+	{
+		std::cout << "ERROR::MATERIAL_DRAW_BENCH::PROGRAM_FAILED" << std::endl;
+		return 1;
+	}
+
+	std::cout << std::string((const char*)glGetString(GL_RENDERER)) << ", " << imageSize << "x" << imageSize
+		<< " materials, " << drawsPerPass << " draws per pass, best of " << iterations << std::endl;
+	std::cout << "materials  binds draws/s  array draws/s  atlas draws/s  array vs binds  atlas vs binds" << std::endl;
+	for (int count = 1; ; count = std::min(count * 4, maxMaterials))
+	{
+		int frames = std::max(drawsPerPass / count, 1);
+		double binds = Time(frames, iterations, count, [&]()
+		{
+			glUseProgram(textureProgram);
+			for (int i = 0; i < count; i++)
+			{
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, textures[i]);
+				glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+			}
+		});
+		double layers = Time(frames, iterations, count, [&]()
+		{
+			glUseProgram(arrayProgram);
+			array.Bind(0);
+			for (int i = 0; i < count; i++)
+				glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+		});
+		double packed = Time(frames, iterations, count, [&]()
+		{
+			glUseProgram(atlasProgram);
+			atlas.Bind(0);
+			for (int i = 0; i < count; i++)
+				glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+		});
+		std::cout << count << "\t   " << (long long)binds << "\t    " << (long long)layers << "\t   " << (long long)packed
+			<< "\t  " << layers / binds << "x\t  " << packed / binds << "x" << std::endl;
+		if (count == maxMaterials)
+			break;
+	}
+
+	glDeleteTextures((int)textures.size(), textures.data());
+	glDeleteBuffers(1, &regionBuffer);
+	glDeleteProgram(textureProgram);
+	glDeleteProgram(arrayProgram);
+	glDeleteProgram(atlasProgram);
+	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,209 @@
+// Shader compile benchmark
+// ------------------------
+// Compiles and links the demo's shader set (Resources/Shaders/vertex.shader
+// and fragment.shader) many times in a hidden GLFW context, two ways:
+//     serial   the old CompileShader/CreateShader helpers: every stage's
+//              GL_COMPILE_STATUS and every program's GL_LINK_STATUS is queried
+//              right after the call, so the driver finishes one before the next
+//     batched  ShaderCompiler: every stage of every program is submitted first,
+//              status is collected afterwards (polled with
+//              GL_COMPLETION_STATUS_KHR when the driver has parallel compile)
+// Each program gets a #define with its own number and the pass number after
+// the #version line, so the driver's shader cache never returns a program
+// compiled before (ProgramCache is not used at all). Printed is the
+// wall-clock time of one pass, best of the iterations, the first pass is
+// discarded.
+//
+// Usage (run from the GraphicPractice directory, build together with Source/*.cpp
+// except Source.cpp):
+//     ShaderCompileBench
+//     ShaderCompileBench --programs 128 --iterations 5
+// With Mesa, MESA_SHADER_CACHE_DISABLE=true keeps the disk cache out of it too.
+
+#include "../../Source/ShaderCompiler.h"
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+static bool ReadFile(const char* path, std::string& text)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "ERROR::SHADER_COMPILE_BENCH::CANNOT_READ " << path << std::endl;
+		return false;
+	}
+	text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+// the define goes after the #version line, which has to stay first
+static std::string MakeVariant(const std::string& source, int pass, int program)
+{
+	size_t line = source.find('\n');
+	std::string define = "#define VARIANT_" + std::to_string(pass) + "_" + std::to_string(program) + "\n";
+	if (line == std::string::npos)
+		return source + "\n" + define;
+	return source.substr(0, line + 1) + define + source.substr(line + 1);
+}
+
+// the helpers ShaderCompiler replaced, status straight after every call
+static unsigned int CompileShader(GLenum type, const std::string& source)
+{
+	unsigned int shader = glCreateShader(type);
+	const char* code = source.c_str();
+	glShaderSource(shader, 1, &code, NULL);
+	glCompileShader(shader);
+	int success;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static unsigned int CreateShader(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	unsigned int vertex = CompileShader(GL_VERTEX_SHADER, vertexSource);
+	unsigned int fragment = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	unsigned int program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	if (!success)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+// best of the iterations in milliseconds, pass(number) builds every program once
+// and returns how many of them linked
+template <typename Pass>
+static double Time(int iterations, int programCount, const char* name, Pass pass)
+{
+	double best = 1e30;
+	for (int i = 0; i <= iterations; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		int linked = pass(i);
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (linked != programCount)
+			std::cout << "ERROR::SHADER_COMPILE_BENCH::" << name << "_FAILED " << programCount - linked << " programs" << std::endl;
+		// the first pass only warms up
+		if (i > 0)
+			best = std::min(best, elapsed);
+	}
+	return best;
+}
+
+int main(int argc, char** argv)
+{
+	int programCount = 64;
+	int iterations = 3;
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (strcmp(argv[arg], "--programs") == 0 && arg + 1 < argc)
+			programCount = std::max(atoi(argv[++arg]), 1);
+		else if (strcmp(argv[arg], "--iterations") == 0 && arg + 1 < argc)
+			iterations = std::max(atoi(argv[++arg]), 1);
+		else
+		{
+			std::cout << "usage: ShaderCompileBench [--programs <n>] [--iterations <n>]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::string vertex, fragment;
+	if (!ReadFile("Resources/Shaders/vertex.shader", vertex) || !ReadFile("Resources/Shaders/fragment.shader", fragment))
+		return 1;
+
+	// hidden window, only the context is needed
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	GLFWwindow* window = glfwCreateWindow(1, 1, "ShaderCompileBench", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return 1;
+	}
+
+	// pass numbers of the two paths never overlap, so no variant is compiled twice
+	int passes = iterations + 1;
+	auto makeSources = [&](int pass, std::vector<std::string>& vertices, std::vector<std::string>& fragments)
+	{
+		vertices.clear();
+		fragments.clear();
+		for (int i = 0; i < programCount; i++)
+		{
+			vertices.push_back(MakeVariant(vertex, pass, i));
+			fragments.push_back(MakeVariant(fragment, pass, i));
+		}
+	};
+	std::vector<std::string> vertices, fragments;
+
+	double serial = Time(iterations, programCount, "SERIAL", [&](int pass)
+	{
+		makeSources(pass, vertices, fragments);
+		std::vector<unsigned int> programs;
+		for (int i = 0; i < programCount; i++)
+			programs.push_back(CreateShader(vertices[i], fragments[i]));
+		int linked = 0;
+		for (unsigned int program : programs)
+		{
+			linked += program != 0;
+			glDeleteProgram(program);
+		}
+		return linked;
+	});
+	double batched = Time(iterations, programCount, "BATCHED", [&](int pass)
+	{
+		makeSources(passes + pass, vertices, fragments);
+		ShaderCompiler compiler;
+		for (int i = 0; i < programCount; i++)
+			compiler.Add(vertices[i], fragments[i]);
+		compiler.Finish();
+		int linked = 0;
+		for (size_t i = 0; i < compiler.Count(); i++)
+			linked += compiler.Succeeded(i);
+		return linked;
+	});
+
+	std::cout << std::string((const char*)glGetString(GL_RENDERER)) << ", " << programCount << " programs, best of "
+		<< iterations << ", parallel compile " << (ShaderCompiler::HasParallelCompile() ? "yes" : "no") << std::endl;
+	std::cout << "serial:  " << serial << " ms (" << serial / programCount << " ms per program)" << std::endl;
+	std::cout << "batched: " << batched << " ms (" << batched / programCount << " ms per program), "
+		<< serial / batched << "x" << std::endl;
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
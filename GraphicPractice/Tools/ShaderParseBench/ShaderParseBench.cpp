@@ -0,0 +1,205 @@
+// Shader parse throughput benchmark
+// ---------------------------------
+// Parses a corpus of multi-stage .shader files two ways and prints the time
+// per pass: ShaderFile (the file is mapped and split once into string_view
+// stages) and the old ParseShader path (ifstream, getline and one
+// stringstream per stage, copied out into std::strings). Both read every
+// file from the page cache, the first pass is discarded. The same two parsers
+// also run on the files already in memory, which leaves out opening and
+// mapping. No GL context is needed, nothing is compiled.
+// Without arguments a corpus of generated files is written to the temp
+// directory first.
+//
+// Usage (run from the GraphicPractice directory, build together with
+// Source/ShaderFile.cpp, Source/AssetFile.cpp, Source/AssetArchive.cpp,
+// Source/BlockCompression.cpp and Source/MappedFile.cpp):
+//     ShaderParseBench
+//     ShaderParseBench --generate 10000 --iterations 5
+//     ShaderParseBench Resources/Shaders
+// Directories are searched recursively for .shader files.
+
+#include "../../Source/ShaderFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// the parser this replaced, extended to every stage ShaderFile knows
+static size_t ParseStream(std::istream& stream)
+{
+	std::string line;
+	std::vector<GLenum> types;
+	std::vector<std::stringstream> sources;
+	int current = -1;
+	while (getline(stream, line))
+	{
+		size_t directive = line.find("#shader");
+		if (directive != std::string::npos)
+		{
+			size_t start = line.find_first_not_of(" \t", directive + 7);
+			size_t end = line.find_last_not_of(" \t\r");
+			std::string name = start == std::string::npos ? std::string() : line.substr(start, end + 1 - start);
+			types.push_back(ShaderFile::StageFromName(name));
+			sources.emplace_back();
+			current = (int)sources.size() - 1;
+		}
+		else if (current >= 0)
+			sources[current] << line << "\n";
+	}
+	size_t bytes = 0;
+	for (std::stringstream& source : sources)
+		bytes += source.str().size();
+	return bytes;
+}
+
+// reads text in memory without copying it, like the file stream reads the page cache
+struct TextBuffer : std::streambuf
+{
+	explicit TextBuffer(const std::string& text)
+	{
+		char* begin = const_cast<char*>(text.data());
+		setg(begin, begin, begin + text.size());
+	}
+};
+
+// vertex and fragment stages of a few kilobytes, every fourth file with a geometry stage
+static void Generate(const std::filesystem::path& directory, int count, std::vector<std::string>& corpus)
+{
+	std::filesystem::create_directories(directory);
+	for (int i = 0; i < count; i++)
+	{
+		std::filesystem::path path = directory / ("generated" + std::to_string(i) + ".shader");
+		std::ofstream file(path);
+		file << "#shader vertex\n#version 330 core\n"
+			"layout (location = 0) in vec3 aPos;\nlayout (location = 1) in vec2 aTexCoord;\n"
+			"uniform mat4 model;\nuniform mat4 view;\nuniform mat4 projection;\nout vec2 TexCoord;\n";
+		for (int j = 0; j < 40 + i % 40; j++)
+			file << "// vertex line " << j << " of shader " << i << ", padding to a realistic size\n";
+		file << "void main()\n{\n\tgl_Position = projection * view * model * vec4(aPos, 1.0);\n\tTexCoord = aTexCoord;\n}\n";
+		if (i % 4 == 0)
+			file << "#shader geometry\n#version 330 core\nlayout (triangles) in;\n"
+				"layout (triangle_strip, max_vertices = 3) out;\nvoid main()\n{\n\tEndPrimitive();\n}\n";
+		file << "#shader fragment\n#version 330 core\nin vec2 TexCoord;\nout vec4 FragColor;\n"
+			"uniform sampler2D texture1;\nuniform sampler2D texture2;\n";
+		for (int j = 0; j < 60 + i % 60; j++)
+			file << "// fragment line " << j << " of shader " << i << ", padding to a realistic size\n";
+		file << "void main()\n{\n\tFragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.2);\n}\n";
+		corpus.push_back(path.string());
+	}
+}
+
+static size_t StageBytes(const std::vector<ShaderStageSource>& stages)
+{
+	size_t bytes = 0;
+	for (const ShaderStageSource& stage : stages)
+		bytes += stage.source.size();
+	return bytes;
+}
+
+// best of the iterations in milliseconds for one pass over the corpus, parse(i)
+// handles file i and returns the bytes of stage source it found
+template <typename Parse>
+static double Time(size_t count, int iterations, Parse parse, size_t& bytes)
+{
+	double best = 1e30;
+	for (int i = 0; i <= iterations; i++)
+	{
+		bytes = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t file = 0; file < count; file++)
+			bytes += parse(file);
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		// the first pass only warms the page cache
+		if (i > 0)
+			best = std::min(best, elapsed);
+	}
+	return best;
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = 5;
+	int generate = 0;
+	std::vector<std::string> paths;
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (strcmp(argv[arg], "--iterations") == 0 && arg + 1 < argc)
+			iterations = std::max(atoi(argv[++arg]), 1);
+		else if (strcmp(argv[arg], "--generate") == 0 && arg + 1 < argc)
+			generate = std::max(atoi(argv[++arg]), 1);
+		else if (std::filesystem::is_directory(argv[arg]))
+		{
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(argv[arg]))
+				if (entry.is_regular_file() && entry.path().extension() == ".shader")
+					paths.push_back(entry.path().string());
+		}
+		else
+			paths.push_back(argv[arg]);
+	}
+	if (paths.empty() && generate == 0)
+		generate = 5000;
+	if (generate > 0)
+	{
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / "ShaderParseBench";
+		Generate(directory, generate, paths);
+		std::cout << "generated " << generate << " files in " << directory.string() << std::endl;
+	}
+
+	// single stage files (no "#shader" lines) go through the preprocessor, not this parser
+	std::vector<std::string> corpus;
+	std::vector<std::string> texts;
+	for (const std::string& path : paths)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		std::vector<ShaderStageSource> stages;
+		if (text.find("#shader") == std::string::npos || !ShaderFile::Parse(text, stages))
+			continue;
+		corpus.push_back(path);
+		texts.push_back(std::move(text));
+	}
+	if (corpus.size() < paths.size())
+		std::cout << "skipped " << paths.size() - corpus.size() << " files without \"#shader\" stages" << std::endl;
+	if (corpus.empty())
+	{
+		std::cout << "usage: ShaderParseBench [--generate <count>] [--iterations <n>] [<.shader file or directory>...]" << std::endl;
+		return 1;
+	}
+
+	size_t bytes = 0;
+	double streams = Time(corpus.size(), iterations, [&](size_t i)
+	{
+		std::ifstream stream(corpus[i]);
+		return ParseStream(stream);
+	}, bytes);
+	double mapped = Time(corpus.size(), iterations, [&](size_t i)
+	{
+		ShaderFile file;
+		return file.Open(corpus[i]) ? StageBytes(file.GetStages()) : 0;
+	}, bytes);
+	double memoryStreams = Time(texts.size(), iterations, [&](size_t i)
+	{
+		TextBuffer buffer(texts[i]);
+		std::istream stream(&buffer);
+		return ParseStream(stream);
+	}, bytes);
+	double memoryViews = Time(texts.size(), iterations, [&](size_t i)
+	{
+		std::vector<ShaderStageSource> stages;
+		ShaderFile::Parse(texts[i], stages);
+		return StageBytes(stages);
+	}, bytes);
+	std::cout << corpus.size() << " files, " << bytes / 1000.0 << " kB of stage source, best of " << iterations << std::endl;
+	std::cout << "files:     streams " << streams << " ms, mapped " << mapped << " ms, speedup " << streams / mapped << "x" << std::endl;
+	std::cout << "in memory: streams " << memoryStreams << " ms, views " << memoryViews << " ms, speedup "
+		<< memoryStreams / memoryViews << "x" << std::endl;
+	return 0;
+}
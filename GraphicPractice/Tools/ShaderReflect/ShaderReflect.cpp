@@ -0,0 +1,241 @@
+// Shader reflection code generator
+// ---------------------------------
+// Links every program of the manifest in a hidden GLFW context, reads the
+// active uniforms back from the driver and writes a header with one struct
+// per program (see Source/ReflectedUniform.h). Renaming or removing a
+// uniform then breaks the build instead of silently setting nothing.
+//
+// Usage (run from the GraphicPractice directory, build together with Source/*.cpp
+// except Source.cpp):
+//     ShaderReflect Source/ShaderUniforms.h Main=Resources/Shaders/vertex.shader,Resources/Shaders/fragment.shader
+// A program given as Name=file.shader uses a multi-stage file.
+// GraphicPractice.vcxproj runs the line above before compiling whenever a
+// shader is newer than the header (target GenerateShaderUniforms), using
+// Tools/ShaderReflect/ShaderReflect.exe or the ShaderReflectExe property.
+
+#include "../../Source/Shader.h"
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <memory>
+
+struct ReflectedProgram
+{
+	std::string name;
+	std::vector<std::string> files;
+	// (uniform name, GL type)
+	std::vector<std::pair<std::string, GLenum>> uniforms;
+};
+
+// C++ type of the generated member, nullptr if Shader has no setter for it
+static const char* CppType(GLenum type)
+{
+	switch (type)
+	{
+	case GL_FLOAT: return "float";
+	case GL_INT: return "int";
+	case GL_BOOL: return "bool";
+	case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_BUFFER:
+	case GL_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_2D:
+	case GL_IMAGE_2D: case GL_IMAGE_2D_ARRAY:
+		// texture units and image units are set as int
+		return "int";
+	}
+	return nullptr;
+}
+
+static const char* GlslType(GLenum type)
+{
+	switch (type)
+	{
+	case GL_FLOAT: return "float";
+	case GL_FLOAT_VEC2: return "vec2";
+	case GL_FLOAT_VEC3: return "vec3";
+	case GL_FLOAT_VEC4: return "vec4";
+	case GL_INT: return "int";
+	case GL_UNSIGNED_INT: return "uint";
+	case GL_BOOL: return "bool";
+	case GL_FLOAT_MAT3: return "mat3";
+	case GL_FLOAT_MAT4: return "mat4";
+	case GL_SAMPLER_2D: return "sampler2D";
+	case GL_SAMPLER_3D: return "sampler3D";
+	case GL_SAMPLER_CUBE: return "samplerCube";
+	case GL_SAMPLER_2D_ARRAY: return "sampler2DArray";
+	}
+	return "other";
+}
+
+// "light.color" -> "light_color", array names lose their "[0]"
+static std::string Identifier(const std::string& name)
+{
+	std::string id;
+	for (char c : name)
+	{
+		if (c == '[')
+			break;
+		id += std::isalnum((unsigned char)c) ? c : '_';
+	}
+	return id;
+}
+
+static bool Reflect(ReflectedProgram& program)
+{
+	std::unique_ptr<Shader> shader(program.files.size() == 1
+		? new Shader(program.files[0].c_str())
+		: new Shader(program.files[0].c_str(), program.files[1].c_str()));
+	unsigned int id = shader->GetID();
+	if (id == 0)
+		return false;
+	program.uniforms.clear();
+	int count = 0;
+	glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+	for (int i = 0; i < count; i++)
+	{
+		char name[256];
+		int length = 0, size = 0;
+		GLenum type;
+		glGetActiveUniform(id, i, sizeof(name), &length, &size, &type, name);
+		// uniforms inside blocks have no location
+		if (glGetUniformLocation(id, name) != -1)
+			program.uniforms.push_back({ std::string(name, length), type });
+	}
+	// driver order is not stable, the header should be
+	std::sort(program.uniforms.begin(), program.uniforms.end());
+	return true;
+}
+
+static bool WriteHeader(const std::string& path, const std::vector<ReflectedProgram>& programs)
+{
+	std::string guard = std::filesystem::path(path).filename().string();
+	for (char& c : guard)
+		c = std::isalnum((unsigned char)c) ? (char)std::toupper((unsigned char)c) : '_';
+
+	std::stringstream out;
+	out << "// Generated by Tools/ShaderReflect, do not edit.\n";
+	out << "// Run it again after changing uniforms in the shaders below.\n";
+	out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+	out << "#include \"ReflectedUniform.h\"\n";
+	for (const ReflectedProgram& program : programs)
+	{
+		out << "\n// ";
+		for (size_t i = 0; i < program.files.size(); i++)
+			out << (i ? ", " : "") << program.files[i];
+		out << "\nstruct " << program.name << "Uniforms\n{\n";
+		// (member, uniform name)
+		std::vector<std::pair<std::string, std::string>> members;
+		for (const auto& uniform : program.uniforms)
+		{
+			const char* type = CppType(uniform.second);
+			std::string baseName = uniform.first.substr(0, uniform.first.find('['));
+			if (!type)
+			{
+				out << "\t// " << GlslType(uniform.second) << " " << uniform.first << ": no typed setter yet\n";
+				continue;
+			}
+			std::string member = Identifier(uniform.first);
+			out << "\tReflectedUniform<" << type << ", UniformNameHash(\"" << baseName << "\")> "
+				<< member << "; // " << GlslType(uniform.second) << "\n";
+			members.push_back({ member, baseName });
+		}
+		out << "\n\t// resolves every uniform once, again after the shader was reloaded\n";
+		out << "\tbool Bind(const Shader& shader)\n\t{\n\t\tbool found = true;\n";
+		for (const auto& member : members)
+			out << "\t\tfound &= " << member.first << ".Bind(shader);\n";
+		out << "\t\treturn found;\n\t}\n";
+		out << "\n\t// uniforms the last Bind did not find, for the error message\n";
+		out << "\tstd::vector<const char*> Missing() const\n\t{\n\t\tstd::vector<const char*> missing;\n";
+		for (const auto& member : members)
+		{
+			out << "\t\tif (!" << member.first << ".handle.IsValid())\n";
+			out << "\t\t\tmissing.push_back(\"" << member.second << "\");\n";
+		}
+		out << "\t\treturn missing;\n\t}\n};\n";
+	}
+	out << "\n#endif\n";
+
+	// leave the file alone when nothing changed so dependent code is not rebuilt
+	std::string text = out.str();
+	std::ifstream existing(path, std::ios::binary);
+	if (existing)
+	{
+		std::stringstream old;
+		old << existing.rdbuf();
+		if (old.str() == text)
+			return true;
+	}
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file << text;
+	return (bool)file;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "usage: ShaderReflect <output.h> <Name>=<vertex>,<fragment> | <Name>=<file.shader> ..." << std::endl;
+		return 1;
+	}
+	std::vector<ReflectedProgram> programs;
+	for (int i = 2; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		size_t equals = arg.find('=');
+		if (equals == std::string::npos)
+		{
+			std::cout << "ERROR::SHADER_REFLECT::BAD_ARGUMENT " << arg << std::endl;
+			return 1;
+		}
+		ReflectedProgram program;
+		program.name = arg.substr(0, equals);
+		std::string files = arg.substr(equals + 1);
+		size_t comma = files.find(',');
+		program.files.push_back(files.substr(0, comma));
+		if (comma != std::string::npos)
+			program.files.push_back(files.substr(comma + 1));
+		programs.push_back(program);
+	}
+
+	// hidden window, only the context is needed
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	GLFWwindow* window = glfwCreateWindow(1, 1, "ShaderReflect", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return 1;
+	}
+
+	int result = 0;
+	for (ReflectedProgram& program : programs)
+	{
+		if (!Reflect(program))
+		{
+			std::cout << "ERROR::SHADER_REFLECT::PROGRAM_FAILED " << program.name << std::endl;
+			result = 1;
+		}
+	}
+	if (result == 0 && !WriteHeader(argv[1], programs))
+	{
+		std::cout << "ERROR::SHADER_REFLECT::CANNOT_WRITE " << argv[1] << std::endl;
+		result = 1;
+	}
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return result;
+}
@@ -0,0 +1,154 @@
+// Offline BCn texture compressor
+// ------------------------------
+// Decodes an image, builds its mip chain (see MipGenerator), encodes every level
+// with BcnEncoder across a thread pool and writes a KTX2 file that
+// TextureLoader uploads without decoding anything. BC4/BC5 hold data rather than
+// color, so their mips are always filtered linearly.
+//
+// Usage (run from the GraphicPractice directory, build together with
+// Source/BcnEncoder.cpp, Source/KtxFile.cpp, Source/TextureImage.cpp,
+// Source/MipGenerator.cpp, Source/CpuFeatures.cpp, Source/PixelKernels.cpp,
+// Source/MappedFile.cpp, Source/ThreadPool.cpp and Source/stb_image.cpp):
+//     TextureCompress bc7 container.jpg container.ktx2
+//     TextureCompress bc3 --flip awesomeface.png awesomeface.ktx2
+//     TextureCompress --benchmark container.jpg
+// --linear marks color data as linear, --flip flips rows like stbi_set_flip_vertically_on_load,
+// --no-mips writes level 0 only. --benchmark prints encode time and PSNR of level 0 for every format.
+
+#include "../../Source/BcnEncoder.h"
+#include "../../Source/KtxFile.h"
+#include "../../Source/PixelKernels.h"
+#include "../../Source/ThreadPool.h"
+#include "../../Source/stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+static const BcFormat allFormats[] = { BcFormat::BC1, BcFormat::BC3, BcFormat::BC4, BcFormat::BC5, BcFormat::BC7 };
+
+// channels a format keeps, the rest are not compared
+static int ComparedChannels(BcFormat format)
+{
+	switch (format)
+	{
+	case BcFormat::BC1: return 3;
+	case BcFormat::BC4: return 1;
+	case BcFormat::BC5: return 2;
+	default: return 4;
+	}
+}
+
+static double Psnr(BcFormat format, const unsigned char* original, const std::vector<unsigned char>& decoded, size_t pixels)
+{
+	int channels = ComparedChannels(format);
+	double error = 0.0;
+	for (size_t i = 0; i < pixels; i++)
+	{
+		for (int c = 0; c < channels; c++)
+		{
+			double delta = (double)original[i * 4 + c] - decoded[i * 4 + c];
+			error += delta * delta;
+		}
+	}
+	double mse = error / ((double)pixels * channels);
+	return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+static int Benchmark(const char* path, ThreadPool& pool)
+{
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(path, &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		std::cout << "ERROR::TEXTURE_COMPRESS::CANNOT_LOAD " << path << ": " << stbi_failure_reason() << std::endl;
+		return 1;
+	}
+	std::cout << path << " " << width << "x" << height << ", " << pool.GetThreadCount() << " threads" << std::endl;
+	for (BcFormat format : allFormats)
+	{
+		// best of a few runs, the first one also warms the pool
+		double best = 1e30;
+		std::vector<unsigned char> blocks;
+		for (int run = 0; run < 3; run++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			blocks = BcnEncoder::EncodeImage(format, pixels, width, height, &pool);
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		std::vector<unsigned char> decoded;
+		BcnEncoder::DecodeImage(format, blocks.data(), width, height, decoded);
+		double megapixels = (double)width * height / 1e6;
+		std::cout << BcnEncoder::FormatName(format) << ": " << best << " ms, " << megapixels * 1000.0 / best
+			<< " MPix/s, PSNR " << Psnr(format, pixels, decoded, (size_t)width * height) << " dB" << std::endl;
+	}
+	stbi_image_free(pixels);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	ThreadPool pool;
+	if (argc == 3 && strcmp(argv[1], "--benchmark") == 0)
+		return Benchmark(argv[2], pool);
+
+	BcFormat format;
+	if (argc < 4 || !BcnEncoder::ParseFormat(argv[1], format))
+	{
+		std::cout << "usage: TextureCompress <bc1|bc3|bc4|bc5|bc7> [--linear] [--flip] [--no-mips] <input> <output.ktx2>" << std::endl;
+		std::cout << "       TextureCompress --benchmark <input>" << std::endl;
+		return 1;
+	}
+	bool srgb = format != BcFormat::BC4 && format != BcFormat::BC5;
+	bool flip = false, mips = true;
+	for (int arg = 2; arg < argc - 2; arg++)
+	{
+		if (strcmp(argv[arg], "--linear") == 0)
+			srgb = false;
+		else if (strcmp(argv[arg], "--flip") == 0)
+			flip = true;
+		else if (strcmp(argv[arg], "--no-mips") == 0)
+			mips = false;
+		else
+			std::cout << "WARNING::TEXTURE_COMPRESS::UNKNOWN_OPTION " << argv[arg] << std::endl;
+	}
+	const char* input = argv[argc - 2];
+	const char* output = argv[argc - 1];
+
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(input, &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		std::cout << "ERROR::TEXTURE_COMPRESS::CANNOT_LOAD " << input << ": " << stbi_failure_reason() << std::endl;
+		return 1;
+	}
+	TextureImage image;
+	image.Assign(pixels, width, height, 4);
+	stbi_image_free(pixels);
+	if (flip)
+		PixelKernels::FlipRows(image.storage.data(), (size_t)width * 4, height);
+	if (mips)
+		image.BuildMips(MipFilter::Kaiser, srgb);
+
+	// block levels packed back to back, the same layout KtxFile::Parse produces
+	TextureImage compressed;
+	compressed.width = width;
+	compressed.height = height;
+	for (size_t i = 0; i < image.levels.size(); i++)
+	{
+		const TextureLevel& level = image.levels[i];
+		std::vector<unsigned char> blocks = BcnEncoder::EncodeImage(format, image.GetLevelData(i), level.width, level.height, &pool);
+		TextureLevel target = level;
+		target.offset = compressed.storage.size();
+		target.size = blocks.size();
+		compressed.storage.insert(compressed.storage.end(), blocks.begin(), blocks.end());
+		compressed.levels.push_back(target);
+	}
+	if (!KtxFile::Write(output, format, srgb, compressed))
+		return 1;
+	std::cout << output << ": " << BcnEncoder::FormatName(format) << (srgb ? " sRGB" : "") << ", "
+		<< compressed.levels.size() << " levels, " << compressed.storage.size() << " bytes" << std::endl;
+	return 0;
+}
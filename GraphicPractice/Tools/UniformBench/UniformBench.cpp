@@ -0,0 +1,181 @@
+// Uniform update benchmark
+// ------------------------
+// Links a program with a number of float and int uniforms in a hidden GLFW
+// context and sets every one of them once per simulated frame, three ways:
+//     lookup   the old setters: a std::string per call, glGetUniformLocation
+//              and glUniform* straight away
+//     names    Shader::setFloat/setInt by name (table lookup) and Flush
+//     handles  Shader::setFloat/setInt with UniformHandles and Flush
+// Each runs twice, once with every value changing every frame and once with
+// the values of the first frame repeated (texture units, constants), where
+// the shadow store drops the redundant updates. Printed is the time per
+// uniform update, best of the iterations. Nothing is drawn, so this is the
+// CPU side of the calls only; glFinish after every pass keeps the driver
+// queue from growing between them.
+//
+// Usage (run from the GraphicPractice directory, build together with Source/*.cpp
+// except Source.cpp):
+//     UniformBench
+//     UniformBench --uniforms 32 --frames 50000 --iterations 5
+
+#include "../../Source/Shader.h"
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+// every uniform feeds the output, so the linker keeps them all active
+static void Generate(int count, std::string& vertex, std::string& fragment, std::vector<std::string>& names)
+{
+	vertex = "#version 330 core\nlayout (location = 0) in vec3 aPos;\nvoid main()\n{\n\tgl_Position = vec4(aPos, 1.0);\n}\n";
+	fragment = "#version 330 core\nout vec4 FragColor;\n";
+	std::string sum;
+	for (int i = 0; i < count; i++)
+	{
+		// every fourth one is an int, like texture units and flags
+		bool isInt = i % 4 == 3;
+		std::string name = (isInt ? "count" : "value") + std::to_string(i);
+		fragment += std::string("uniform ") + (isInt ? "int " : "float ") + name + ";\n";
+		sum += (isInt ? " + float(" + name + ")" : " + " + name);
+		names.push_back(name);
+	}
+	fragment += "void main()\n{\n\tFragColor = vec4(0.0" + sum + ");\n}\n";
+}
+
+// the setters before the shadow store, names go through a std::string like the callers' literals did
+static void SetIntByLookup(unsigned int program, const std::string& name, int value)
+{
+	glUniform1i(glGetUniformLocation(program, name.c_str()), value);
+}
+
+static void SetFloatByLookup(unsigned int program, const std::string& name, float value)
+{
+	glUniform1f(glGetUniformLocation(program, name.c_str()), value);
+}
+
+// best of the iterations in nanoseconds per update, pass(frame) sets every uniform once
+template <typename Pass>
+static double Time(int frames, int iterations, size_t updatesPerFrame, Pass pass)
+{
+	double best = 1e30;
+	for (int i = 0; i <= iterations; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; frame++)
+			pass(frame);
+		glFinish();
+		double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		// the first pass only warms up
+		if (i > 0)
+			best = std::min(best, elapsed / ((double)frames * updatesPerFrame));
+	}
+	return best;
+}
+
+int main(int argc, char** argv)
+{
+	int uniformCount = 16;
+	int frames = 20000;
+	int iterations = 3;
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (strcmp(argv[arg], "--uniforms") == 0 && arg + 1 < argc)
+			uniformCount = std::max(atoi(argv[++arg]), 1);
+		else if (strcmp(argv[arg], "--frames") == 0 && arg + 1 < argc)
+			frames = std::max(atoi(argv[++arg]), 1);
+		else if (strcmp(argv[arg], "--iterations") == 0 && arg + 1 < argc)
+			iterations = std::max(atoi(argv[++arg]), 1);
+		else
+		{
+			std::cout << "usage: UniformBench [--uniforms <n>] [--frames <n>] [--iterations <n>]" << std::endl;
+			return 1;
+		}
+	}
+
+	// hidden window, only the context is needed
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	GLFWwindow* window = glfwCreateWindow(1, 1, "UniformBench", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return 1;
+	}
+
+	std::string vertex, fragment;
+	std::vector<std::string> names;
+	Generate(uniformCount, vertex, fragment, names);
+	Shader shader(Shader::BuildProgram(vertex, fragment));
+	if (shader.GetID() == 0 || shader.GetUniformSlots().size() != names.size())
+	{
+		std::cout << "ERROR::UNIFORM_BENCH::PROGRAM_FAILED" << std::endl;
+		return 1;
+	}
+	shader.use();
+	unsigned int program = shader.GetID();
+	std::vector<UniformHandle> handles;
+	for (const std::string& name : names)
+		handles.push_back(shader.GetUniform(name));
+
+	std::cout << std::string((const char*)glGetString(GL_RENDERER)) << ", " << names.size() << " uniforms, "
+		<< frames << " frames, best of " << iterations << std::endl;
+	for (int changing = 1; changing >= 0; changing--)
+	{
+		// frame 0 for every frame when the values stay the same
+		auto value = [&](int frame, size_t i) { return changing ? frame + (int)i : (int)i; };
+		double lookup = Time(frames, iterations, names.size(), [&](int frame)
+		{
+			for (size_t i = 0; i < names.size(); i++)
+			{
+				if (i % 4 == 3)
+					SetIntByLookup(program, names[i].c_str(), value(frame, i));
+				else
+					SetFloatByLookup(program, names[i].c_str(), (float)value(frame, i));
+			}
+		});
+		double byName = Time(frames, iterations, names.size(), [&](int frame)
+		{
+			for (size_t i = 0; i < names.size(); i++)
+			{
+				if (i % 4 == 3)
+					shader.setInt(names[i].c_str(), value(frame, i));
+				else
+					shader.setFloat(names[i].c_str(), (float)value(frame, i));
+			}
+			shader.Flush();
+		});
+		double byHandle = Time(frames, iterations, names.size(), [&](int frame)
+		{
+			for (size_t i = 0; i < handles.size(); i++)
+			{
+				if (i % 4 == 3)
+					shader.setInt(handles[i], value(frame, i));
+				else
+					shader.setFloat(handles[i], (float)value(frame, i));
+			}
+			shader.Flush();
+		});
+		std::cout << (changing ? "values changing:  " : "values repeated:  ") << "lookup " << lookup << " ns, names "
+			<< byName << " ns, handles " << byHandle << " ns per update, handles vs lookup " << lookup / byHandle
+			<< "x" << std::endl;
+	}
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}